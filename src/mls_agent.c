@@ -0,0 +1,263 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Runner side of the agent mode. Instead of fork+exec of a new helper for
+ * every step, one helper per (level, binary) is started through the usual
+ * range transition and kept resident; each step is then sent to it as a
+ * command line over a pair of FIFOs labeled at the helper's level.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <CUnit/CUnit.h>
+#include "mls_agent.h"
+#include "mls_serve.h"
+
+int agent_mode = 0;
+
+/* A channel FIFO: the prefix in chan, then an extension */
+#define AGENT_PATH  (MAX_STRING + sizeof(SERVE_CMD_EXT))
+
+static struct mls_agent agents[MAX_AGENTS];
+static int nagents = 0;
+
+
+static int agent_alive(struct mls_agent *a)
+{
+    int status;
+
+    if (a->pid <= 0) return 0;
+    if (waitpid(a->pid, &status, WNOHANG) == a->pid) {
+        fprintf(stderr, "agent %s@%s died\n", a->prog, a->lvl);
+        a->pid = -1;
+        return 0;
+    }
+    return 1;
+}
+
+
+static void agent_close(struct mls_agent *a)
+{
+    char path[AGENT_PATH];
+
+    if (a->cmd_fd >= 0) close(a->cmd_fd);
+    if (a->rep_fd >= 0) close(a->rep_fd);
+    a->cmd_fd = a->rep_fd = -1;
+    snprintf(path, sizeof(path), "%s%s", a->chan, SERVE_CMD_EXT);
+    unlink(path);
+    snprintf(path, sizeof(path), "%s%s", a->chan, SERVE_REP_EXT);
+    unlink(path);
+}
+
+
+/*
+ * Create the channel, launch the helper at its level and wait for it to
+ * open the command FIFO
+ */
+static int agent_start(struct mls_agent *a)
+{
+    char cmd_path[AGENT_PATH];
+    char rep_path[AGENT_PATH];
+    char name[MAX_STRING];
+    const struct level_context *ctx;
+    const char *base;
+    struct timespec pause = { 0, 1000000 };
+    int flags;
+
+    base = strrchr(a->prog, '/');
+    base = base ? base + 1 : a->prog;
+    // levels with categories are too long for a file name; use the slot
+    if (snprintf(name, sizeof(name), "files/agent.%d.%s",
+                 (int)(a - agents), base) >= (int)sizeof(name)) {
+        fprintf(stderr, "agent name for %s too long\n", a->prog);
+        return -1;
+    }
+    worker_name(a->chan, sizeof(a->chan), name);
+    snprintf(cmd_path, sizeof(cmd_path), "%s%s", a->chan, SERVE_CMD_EXT);
+    snprintf(rep_path, sizeof(rep_path), "%s%s", a->chan, SERVE_REP_EXT);
+
+    unlink(cmd_path);
+    unlink(rep_path);
+    if (create_fifo(a->lvl, cmd_path) != 0 ||
+        create_fifo(a->lvl, rep_path) != 0) {
+        return -1;
+    }
+
+    ctx = level_context(a->lvl);
+    fflush(stdout); fflush(stderr);
+    a->pid = fork();
+    switch (a->pid) {
+        case -1:
+            perror("fork failed");
+            return -1;
+        case 0:
+            chcon_to_context(ctx);
+            execlp(a->prog, a->prog, SERVE_OPT, a->chan, (char *)NULL);
+            perror("exec failed");
+            _exit(-1);
+    }
+    fprintf(stderr, "agent %s@%s is pid %d\n", a->prog, a->lvl, a->pid);
+
+    // a non-blocking open fails until the agent is reading
+    while ((a->cmd_fd = open(cmd_path,
+                             O_WRONLY | O_NONBLOCK | O_CLOEXEC)) < 0) {
+        if (errno != ENXIO || !agent_alive(a)) {
+            perror("open command channel failed");
+            agent_close(a);
+            return -1;
+        }
+        nanosleep(&pause, NULL);
+    }
+    flags = fcntl(a->cmd_fd, F_GETFL);
+    fcntl(a->cmd_fd, F_SETFL, flags & ~O_NONBLOCK);
+
+    a->rep_fd = open(rep_path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (a->rep_fd < 0) {
+        perror("open reply channel failed");
+        agent_close(a);
+        return -1;
+    }
+    return 0;
+}
+
+
+static struct mls_agent *agent_get(const char *lvl, const char *prog)
+{
+    struct mls_agent *a;
+    int i;
+
+    for (i = 0; i < nagents; i++) {
+        a = &agents[i];
+        if (!strcmp(a->lvl, lvl) && !strcmp(a->prog, prog)) {
+            return (a->pid > 0) ? a : NULL;
+        }
+    }
+    if (nagents == MAX_AGENTS) {
+        fprintf(stderr, "too many agents\n");
+        return NULL;
+    }
+
+    // a dead agent is never restarted; its slot stays to record that
+    a = &agents[nagents++];
+    memset(a, 0, sizeof(*a));
+    snprintf(a->lvl, sizeof(a->lvl), "%s", lvl);
+    snprintf(a->prog, sizeof(a->prog), "%s", prog);
+    a->cmd_fd = a->rep_fd = -1;
+    signal(SIGPIPE, SIG_IGN);
+    if (agent_start(a) != 0) {
+        a->pid = -1;
+        return NULL;
+    }
+    return a;
+}
+
+
+/*
+ * Read the reply line, checking now and then that the agent is still there
+ */
+static int agent_reply(struct mls_agent *a)
+{
+    struct pollfd pfd = { a->rep_fd, POLLIN, 0 };
+    char line[MAX_STRING];
+    size_t len = 0;
+    ssize_t n;
+    int ret;
+
+    while (len < sizeof(line) - 1) {
+        ret = poll(&pfd, 1, AGENT_POLL_MS);
+        if (ret < 0 && errno != EINTR) return -1;
+        if (ret <= 0) {
+            if (!agent_alive(a)) return -1;
+            continue;
+        }
+        n = read(a->rep_fd, line + len, 1);
+        if (n < 0 && (errno == EAGAIN || errno == EINTR)) continue;
+        if (n <= 0) return -1;
+        if (line[len] == '\n') break;
+        len++;
+    }
+    line[len] = '\0';
+    return atoi(line);
+}
+
+
+/*
+ * Send argv[1..] to the agent for (lvl, argv[0])
+ *
+ * Returns the exit status of the step, as fork_to_lvl() would see it, or
+ * -1 if no agent could run it
+ */
+int agent_run(const char *lvl, char * const argv[])
+{
+    struct mls_agent *a;
+    char line[SERVE_MAX_LINE];
+    size_t len = 0;
+    int i;
+
+    for (i = 1; argv[i] != NULL; i++) {
+        if (strpbrk(argv[i], " \t\n") != NULL) {
+            fprintf(stderr, "argument '%s' cannot be sent to an agent\n",
+                    argv[i]);
+            return -1;
+        }
+        len += snprintf(line + len, sizeof(line) - len, "%s%s",
+                        (i > 1) ? " " : "", argv[i]);
+        if (len >= sizeof(line) - 1) return -1;
+    }
+    line[len++] = '\n';
+
+    a = agent_get(lvl, argv[0]);
+    if (a == NULL) return -1;
+
+    fprintf(stderr, "agent %s@%s: %.*s", a->prog, a->lvl, (int)len, line);
+    if (write(a->cmd_fd, line, len) != (ssize_t)len) {
+        perror("write command failed");
+        return -1;
+    }
+    a->commands++;
+    return agent_reply(a);
+}
+
+
+/*
+ * Tell every agent to quit and report how many launches were saved
+ */
+void agents_stop(void)
+{
+    struct mls_agent *a;
+    unsigned int commands = 0;
+    int status;
+    int i;
+
+    for (i = 0; i < nagents; i++) {
+        a = &agents[i];
+        if (a->pid > 0) {
+            if (write(a->cmd_fd, SERVE_QUIT "\n", strlen(SERVE_QUIT) + 1) < 0)
+                kill(a->pid, SIGTERM);
+            while (waitpid(a->pid, &status, 0) == -1 && errno == EINTR)
+                ;
+            a->pid = -1;
+        }
+        agent_close(a);
+        commands += a->commands;
+    }
+    if (nagents > 0) {
+        fprintf(stderr, "agents: %d launched, %u commands served\n",
+                nagents, commands);
+    }
+    nagents = 0;
+}
@@ -0,0 +1,33 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_AGENT_H__
+#define __TEST_MLS_AGENT_H__
+#include <sys/types.h>
+#include "mls_support.h"
+
+#define MAX_AGENTS 256
+#define AGENT_POLL_MS 100
+
+struct mls_agent {
+    char lvl[MAX_STRING];       // level the helper runs at
+    char prog[MAX_STRING];      // helper binary
+    char chan[MAX_STRING];      // FIFO prefix, see mls_serve.h
+    pid_t pid;
+    int cmd_fd;
+    int rep_fd;
+    unsigned int commands;
+};
+
+extern int agent_mode;
+
+int agent_run(const char *lvl, char * const argv[]);
+void agents_stop(void);
+
+#endif
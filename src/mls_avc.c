@@ -0,0 +1,84 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Policy pre-check. Instead of launching helpers for every cell, ask the
+ * loaded policy through the userspace AVC whether the subject's context
+ * may use the permission on the object's context. Decisions are cached
+ * by the AVC, so a full matrix costs a few hundred lookups; only a
+ * sample of the cells is then run for real, to confirm that the kernel
+ * does what the policy says.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <selinux/selinux.h>
+#include <selinux/avc.h>
+#include "mls_avc.h"
+
+int avc_confirm = -1;
+
+static int avc_ready = 0;
+
+
+int avc_precheck_init(void)
+{
+    if (avc_ready) return 0;
+    if (avc_open(NULL, 0) != 0) {
+        perror("avc_open failed");
+        return -1;
+    }
+    avc_ready = 1;
+    return 0;
+}
+
+/*
+ * Does the policy let scon use perm on tcon of class tclass. The decision
+ * is read from the access vector rather than the return code, so it is
+ * the policy's answer even when the system is permissive.
+ *
+ * Returns 1 if allowed, 0 if denied, -1 if the question cannot be asked
+ */
+int avc_decide(const char *scon, const char *tcon, const char *tclass,
+               const char *perm)
+{
+    security_id_t ssid, tsid;
+    struct avc_entry_ref aeref;
+    struct av_decision avd;
+    security_class_t cls;
+    access_vector_t av;
+
+    if (!avc_ready && avc_precheck_init() != 0) return -1;
+
+    cls = string_to_security_class(tclass);
+    av = cls ? string_to_av_perm(cls, perm) : 0;
+    if (cls == 0 || av == 0) {
+        fprintf(stderr, "policy has no %s:%s\n", tclass, perm);
+        return -1;
+    }
+    if (avc_context_to_sid(scon, &ssid) != 0 ||
+        avc_context_to_sid(tcon, &tsid) != 0) {
+        perror("avc_context_to_sid failed");
+        return -1;
+    }
+
+    avc_entry_ref_init(&aeref);
+    if (avc_has_perm_noaudit(ssid, tsid, cls, av, &aeref, &avd) != 0 &&
+        errno != EACCES) {
+        perror("avc_has_perm_noaudit failed");
+        return -1;
+    }
+    return (avd.allowed & av) == av;
+}
+
+void avc_precheck_stop(void)
+{
+    if (!avc_ready) return;
+    avc_destroy();
+    avc_ready = 0;
+}
@@ -0,0 +1,20 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_AVC_H__
+#define __TEST_MLS_AVC_H__
+
+extern int avc_confirm;     // percent of cells to run for real, -1 = off
+
+int avc_precheck_init(void);
+int avc_decide(const char *scon, const char *tcon, const char *tclass,
+               const char *perm);
+void avc_precheck_stop(void);
+
+#endif
@@ -0,0 +1,3816 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * IPC benchmark harness, built from the helpers' object primitives. Each
+ * benchmark is an operation timed on side A, either alone (sem: set and
+ * get) or as a round trip through a second process, side B (shm, shm_v,
+ * msg: A writes, B reads and writes back, A reads). Each side can be
+ * pinned to a cpu. After the warmup iterations, every iteration is timed
+ * with CLOCK_MONOTONIC and the samples are sorted for the percentiles.
+ * Results carry the kernel release and the security context they were
+ * taken under, so runs on different kernels and levels can be compared.
+ *
+ * With -c the same read loops are instead timed three ways, to isolate
+ * what MLS enforcement costs per syscall; see the comparison section.
+ *
+ * The primitives log to stdout; it is sent to /dev/null while timing.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <stdint.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <math.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/msg.h>
+#include <sys/sem.h>
+#include <sys/shm.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/utsname.h>
+#include <selinux/selinux.h>
+#ifdef __NR_io_uring_setup
+#include <linux/io_uring.h>
+#endif
+#include "mls_support.h"
+#include "mls_helper.h"
+#include "mls_wait.h"
+
+#define BENCH_DATA   "7"        // a valid semaphore value, too
+#define BENCH_SHM_A  "/mls_bench_a"
+#define BENCH_SHM_B  "/mls_bench_b"
+#define BENCH_KEY_A  "files/bench.a"
+#define BENCH_KEY_B  "files/bench.b"
+
+struct bench {
+    const char *name;
+    void (*setup)(void);
+    void (*side_a)(void);       // one timed iteration
+    void (*side_b)(void);       // the other end of it, or NULL
+    void (*teardown)(void);
+};
+
+struct stats {
+    double mean, p50, p99, p999, min, max;  // ns
+};
+
+struct bench_result {
+    const struct bench *b;
+    struct stats s;
+};
+
+static struct shared_space_t *seg[2];
+static int ids[2];
+
+static int warmup = -1;             // -w; the default depends on the mode
+static int iters = -1;              // -n; likewise
+static int cpu_a = -1;
+static int cpu_b = -1;
+static int stream_size = 0;         // -s: payload of a message stream
+static int stream_nowait = 0;       // -N: stream with IPC_NOWAIT
+static size_t seg_size = 0;         // -z for -m: a shared memory segment
+static size_t fifo_size = 0;        // -z for -F: bytes a FIFO pass
+static size_t file_size = 0;        // -z for -R: the low file
+static size_t chan_size = 0;        // -z for -C: the cache channel's file
+static const char *seg_optarg = ""; // -x for -m, as given
+static const char *sem_optarg = ""; // -x for -P, as given
+static int seg_opts = 0;            // -x for -m, as SEG_ flags
+static int chan_slot_us = 0;        // -t: a covert channel's bit slot
+static uint64_t chan_start_ns = 0;  // -T: when the sides' slot 0 begins
+
+/*
+ * The mode -z and -x are for, named by the -X prefix of its sides
+ */
+struct mode_args {
+    const char *side;
+    size_t *size;                   // -z, or NULL
+    const char **opts;              // -x, or NULL
+};
+
+static const struct mode_args modes[] = {
+    {"bw-",   &seg_size,  &seg_optarg},
+    {"sem-",  NULL,       &sem_optarg},
+    {"fifo-", &fifo_size, NULL},
+    {"file-", &file_size, NULL},
+    {"chan-", &chan_size, NULL},
+    {NULL, NULL, NULL}
+};
+
+static const struct mode_args *find_mode(const char *side)
+{
+    const struct mode_args *m;
+
+    for (m = modes; side != NULL && m->side != NULL; m++) {
+        if (strncmp(side, m->side, strlen(m->side)) == 0) return m;
+    }
+    return NULL;
+}
+
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void fail(const char *what)
+{
+    perror(what);
+    exit(-1);
+}
+
+static void pin(int cpu)
+{
+    cpu_set_t set;
+
+    if (cpu < 0) return;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+        perror("sched_setaffinity failed");
+        exit(-1);
+    }
+}
+
+/*
+ * A cpu we may not run on would only fail in the middle of a round trip
+ */
+static int usable(int cpu)
+{
+    cpu_set_t set;
+
+    if (cpu < 0) return 1;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+    return cpu < CPU_SETSIZE && CPU_ISSET(cpu, &set);
+}
+
+static void key_files(void)
+{
+    int fd;
+
+    if ((fd = open(BENCH_KEY_A, O_CREAT | O_WRONLY, 0666)) >= 0) close(fd);
+    if ((fd = open(BENCH_KEY_B, O_CREAT | O_WRONLY, 0666)) >= 0) close(fd);
+}
+
+
+/*****************************************************************************
+ * Benchmarks. A round trip hands the data over in one object and back in
+ * the other; the reader of a segment marks it ready again before replying.
+ */
+
+static void shm_setup(void)
+{
+    shm_unlink(BENCH_SHM_A);
+    shm_unlink(BENCH_SHM_B);
+    create_shm(&seg[0], BENCH_SHM_A, 0);
+    create_shm(&seg[1], BENCH_SHM_B, 0);
+}
+
+static void shm_v_setup(void)
+{
+    key_files();
+    ids[0] = create_shm_v(&seg[0], BENCH_KEY_A, 0);
+    ids[1] = create_shm_v(&seg[1], BENCH_KEY_B, 0);
+}
+
+static void shm_a(void)
+{
+    write_shm(seg[0], BENCH_DATA, 0);
+    read_shm(seg[1], BENCH_DATA, 0);
+    __atomic_store_n(&seg[1]->state, STATE_READY, __ATOMIC_RELEASE);
+}
+
+static void shm_b(void)
+{
+    read_shm(seg[0], BENCH_DATA, 0);
+    __atomic_store_n(&seg[0]->state, STATE_READY, __ATOMIC_RELEASE);
+    write_shm(seg[1], BENCH_DATA, 0);
+}
+
+static void shm_teardown(void)
+{
+    close_shm(BENCH_SHM_A);
+    close_shm(BENCH_SHM_B);
+}
+
+static void shm_v_teardown(void)
+{
+    close_shm_v(BENCH_KEY_A);
+    close_shm_v(BENCH_KEY_B);
+}
+
+static void msg_setup(void)
+{
+    key_files();
+    ids[0] = create_msgq(BENCH_KEY_A, 0);
+    ids[1] = create_msgq(BENCH_KEY_B, 0);
+}
+
+static void msg_a(void)
+{
+    write_msg(ids[0], BENCH_DATA, 0);
+    read_msg(ids[1], BENCH_DATA, 0);
+}
+
+static void msg_b(void)
+{
+    read_msg(ids[0], BENCH_DATA, 0);
+    write_msg(ids[1], BENCH_DATA, 0);
+}
+
+static void msg_teardown(void)
+{
+    close_msgq(BENCH_KEY_A, 0);
+    close_msgq(BENCH_KEY_B, 0);
+}
+
+static void sem_setup(void)
+{
+    key_files();
+    ids[0] = create_sem(BENCH_KEY_A, 0);
+}
+
+static void sem_a(void)
+{
+    write_sem(ids[0], BENCH_DATA, 0);
+    read_sem(ids[0], BENCH_DATA, 0);
+}
+
+static void sem_teardown(void)
+{
+    close_sem(BENCH_KEY_A, 0);
+}
+
+static const struct bench benches[] = {
+    {"shm",   shm_setup,   shm_a, shm_b, shm_teardown},
+    {"shm_v", shm_v_setup, shm_a, shm_b, shm_v_teardown},
+    {"msg",   msg_setup,   msg_a, msg_b, msg_teardown},
+    {"sem",   sem_setup,   sem_a, NULL,  sem_teardown},
+    {NULL, NULL, NULL, NULL, NULL}
+};
+
+
+/*****************************************************************************
+ * Harness
+ */
+
+static int by_value(const void *a, const void *b)
+{
+    uint64_t x = *(const uint64_t *)a, y = *(const uint64_t *)b;
+
+    return (x > y) - (x < y);
+}
+
+static double quantile(const uint64_t *s, int n, double q)
+{
+    int i = (int)(q * n);
+
+    return s[(i < n) ? i : n - 1];
+}
+
+/*
+ * Summarize n samples, sorting them in place
+ */
+static void summarize(uint64_t *samples, int n, struct stats *s)
+{
+    double sum = 0;
+    int i;
+
+    qsort(samples, n, sizeof(*samples), by_value);
+    for (i = 0; i < n; i++) sum += samples[i];
+    s->mean = sum / n;
+    s->p50 = quantile(samples, n, 0.50);
+    s->p99 = quantile(samples, n, 0.99);
+    s->p999 = quantile(samples, n, 0.999);
+    s->min = samples[0];
+    s->max = samples[n - 1];
+}
+
+/*
+ * Arrays of iters samples, one per timed syscall or phase
+ */
+static void alloc_samples(uint64_t *samples[], int n)
+{
+    int k;
+
+    for (k = 0; k < n; k++) {
+        samples[k] = malloc(iters * sizeof(uint64_t));
+        if (samples[k] == NULL) fail("malloc failed");
+    }
+}
+
+static void free_samples(uint64_t *samples[], int n)
+{
+    int k;
+
+    for (k = 0; k < n; k++) free(samples[k]);
+}
+
+/*
+ * A side at a level hands its samples back through a file the runner
+ * created at that level
+ */
+static void write_samples(const char *path, uint64_t *samples[], int n)
+{
+    size_t len = iters * sizeof(uint64_t);
+    int fd = open(path, O_WRONLY | O_TRUNC);
+    int k;
+
+    if (fd < 0) fail("open samples failed");
+    for (k = 0; k < n; k++) {
+        if (write(fd, samples[k], len) != (ssize_t)len) fail("write failed");
+    }
+    close(fd);
+}
+
+static int read_samples(const char *path, uint64_t *samples[], int n)
+{
+    size_t len = iters * sizeof(uint64_t);
+    FILE *f = fopen(path, "r");
+    int status = 0;
+    int k;
+
+    if (f == NULL) return -1;
+    for (k = 0; k < n && status == 0; k++) {
+        if (fread(samples[k], 1, len, f) != len) status = -1;
+    }
+    fclose(f);
+    return status;
+}
+
+static int run_bench(const struct bench *b, struct bench_result *r)
+{
+    uint64_t *samples;
+    uint64_t start;
+    pid_t pid = -1;
+    int status;
+    int i;
+
+    samples = malloc(iters * sizeof(*samples));
+    if (samples == NULL) {
+        perror("malloc failed");
+        return -1;
+    }
+
+    b->setup();
+    fflush(stdout);
+    if (b->side_b != NULL) {
+        pid = fork();
+        if (pid == -1) {
+            perror("fork failed");
+            free(samples);
+            return -1;
+        }
+        if (pid == 0) {
+            pin(cpu_b);
+            for (i = 0; i < warmup + iters; i++) b->side_b();
+            fflush(stdout);
+            _exit(0);
+        }
+    }
+
+    pin(cpu_a);
+    for (i = 0; i < warmup; i++) b->side_a();
+    for (i = 0; i < iters; i++) {
+        start = now_ns();
+        b->side_a();
+        samples[i] = now_ns() - start;
+    }
+
+    if (pid > 0) {
+        while (waitpid(pid, &status, 0) == -1 && errno == EINTR)
+            ;
+    }
+    b->teardown();
+
+    r->b = b;
+    summarize(samples, iters, &r->s);
+    free(samples);
+    return 0;
+}
+
+
+static void print_results(FILE *out, const char *format,
+                          const struct bench_result *res, int n)
+{
+    struct utsname u;
+    char *con = NULL;
+    const char *context;
+    int i;
+
+    uname(&u);
+    context = (getcon(&con) == 0 && con != NULL) ? con : "unlabeled";
+
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "bench,kernel,context,warmup,iterations,cpu_a,cpu_b,"
+                     "mean_ns,p50_ns,p99_ns,p999_ns,min_ns,max_ns\n");
+        for (i = 0; i < n; i++) {
+            fprintf(out, "%s,%s,%s,%d,%d,%d,%d,%.0f,%.0f,%.0f,%.0f,%.0f,"
+                    "%.0f\n", res[i].b->name, u.release, context, warmup,
+                    iters, cpu_a, cpu_b, res[i].s.mean, res[i].s.p50,
+                    res[i].s.p99, res[i].s.p999, res[i].s.min, res[i].s.max);
+        }
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+        for (i = 0; i < n; i++) {
+            fprintf(out, "  {\"bench\": \"%s\", \"kernel\": \"%s\", "
+                    "\"context\": \"%s\", \"warmup\": %d, "
+                    "\"iterations\": %d, \"cpu_a\": %d, \"cpu_b\": %d, "
+                    "\"mean_ns\": %.0f, \"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+                    "\"p999_ns\": %.0f, \"min_ns\": %.0f, "
+                    "\"max_ns\": %.0f}%s\n", res[i].b->name, u.release,
+                    context, warmup, iters, cpu_a, cpu_b, res[i].s.mean,
+                    res[i].s.p50, res[i].s.p99, res[i].s.p999, res[i].s.min,
+                    res[i].s.max, (i + 1 < n) ? "," : "");
+        }
+        fprintf(out, "]\n");
+    } else {
+        fprintf(out, "kernel %s, context %s, %d iterations after %d\n",
+                u.release, context, iters, warmup);
+        fprintf(out, "%-6s %10s %10s %10s %10s %10s  (us)\n", "bench",
+                "mean", "p50", "p99", "p99.9", "max");
+        for (i = 0; i < n; i++) {
+            fprintf(out, "%-6s %10.2f %10.2f %10.2f %10.2f %10.2f\n",
+                    res[i].b->name, res[i].s.mean / 1e3,
+                    res[i].s.p50 / 1e3, res[i].s.p99 / 1e3,
+                    res[i].s.p999 / 1e3, res[i].s.max / 1e3);
+        }
+    }
+    freecon(con);
+}
+
+
+/*****************************************************************************
+ * Comparison (-c). The same read loop, one or two syscalls an iteration,
+ * is timed three ways:
+ *
+ *   runner  in the runner's own context, with no level change
+ *   same    the reader at the low level, like the object
+ *   down    the reader at the high level, reading down
+ *
+ * Objects are created, fed and removed at the low level in every case;
+ * only the reader moves. Levels are entered as the test helpers enter
+ * them, by re-executing mls_bench (-X side) under setexeccon(). A reader
+ * at a level passes its samples back in a file at that level.
+ *
+ * The msgsnd loop times the writer instead, with a low side draining the
+ * queue. A high writer would write down, which MLS denies, so it runs in
+ * the runner and same configurations only.
+ */
+
+#define CMP_KEY      "files/bench.key"
+#define CMP_FIFO     "files/bench.fifo"
+#define CMP_FILE     "files/bench.data"
+#define CMP_SAMPLES  "log/bench.%s.samples"
+#define CMP_RECORD   64         // FIFO record; under PIPE_BUF, so atomic
+#define SELF_EXE     "/proc/self/exe"
+
+enum cmp_config { CMP_RUNNER, CMP_SAME, CMP_DOWN, CMP_CONFIGS };
+
+static const char *cmp_names[CMP_CONFIGS] = { "runner", "same", "down" };
+
+struct cmp_bench {
+    const char *name;
+    const char *syscalls[2];        // timed each iteration; or NULL
+    const char *fixture;            // created by the runner at low
+    int (*create)(const char *path);
+    void (*setup)(void);
+    void (*feed)(void);             // keeps the reader supplied, or NULL
+    void (*read)(uint64_t *samples[2]);
+    void (*teardown)(void);
+    int writes;                     // times a write: no down config
+};
+
+struct cmp_result {
+    const struct cmp_bench *b;
+    const char *syscall;
+    struct stats s[CMP_CONFIGS];
+};
+
+static const char *self = "./mls_bench";  // argv[0], passed to the sides
+static const char *lvl_low = LVL_LOW;
+static const char *lvl_high = LVL_HIGH;
+
+
+static int cmp_key(const char *path)
+{
+    return create_file(lvl_low, path, NULL);
+}
+
+static int cmp_data(const char *path)
+{
+    return create_file(lvl_low, path, LOW_CONTENTS);
+}
+
+static int cmp_fifo(const char *path)
+{
+    unlink(path);
+    return create_fifo(lvl_low, path);
+}
+
+/*
+ * Time one iteration of a loop; the warmup iterations have i < 0
+ */
+#define CMP_TIME(i, samples, call) do {                 \
+        uint64_t __start = now_ns();                    \
+        call;                                           \
+        if ((i) >= 0) (samples)[i] = now_ns() - __start; \
+    } while (0)
+
+
+static void cmp_msg_setup(void)
+{
+    create_msgq(CMP_KEY, 0);
+}
+
+static void cmp_msg_feed(void)
+{
+    int id = attach_msgq(O_WRONLY, CMP_KEY, 0);
+    int i;
+
+    for (i = 0; i < warmup + iters; i++) write_msg(id, BENCH_DATA, 0);
+}
+
+static void cmp_msg_read(uint64_t *samples[2])
+{
+    struct {
+        long mtype;
+        char mtext[MEM_SIZE];
+    } msg;
+    int id = attach_msgq(O_RDONLY, CMP_KEY, 0);
+    ssize_t n = 0;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        CMP_TIME(i, samples[0],
+                 n = msgrcv(id, &msg, sizeof(msg.mtext), 0, 0));
+        if (n == -1) fail("msgrcv failed");
+    }
+}
+
+/*
+ * The msgsnd loop's low side: receive every message the writer sends
+ */
+static void cmp_msg_drain(void)
+{
+    struct {
+        long mtype;
+        char mtext[MEM_SIZE];
+    } msg;
+    int id = attach_msgq(O_RDONLY, CMP_KEY, 0);
+    int i;
+
+    for (i = 0; i < warmup + iters; i++) {
+        if (msgrcv(id, &msg, sizeof(msg.mtext), 0, 0) == -1) {
+            fail("msgrcv failed");
+        }
+    }
+}
+
+static void cmp_msg_write(uint64_t *samples[2])
+{
+    struct {
+        long mtype;
+        char mtext[MEM_SIZE];
+    } msg = { 1, BENCH_DATA };
+    int id = attach_msgq(O_WRONLY, CMP_KEY, 0);
+    int status = 0;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        CMP_TIME(i, samples[0],
+                 status = msgsnd(id, &msg, sizeof(msg.mtext), 0));
+        if (status == -1) fail("msgsnd failed");
+    }
+}
+
+static void cmp_msg_teardown(void)
+{
+    close_msgq(CMP_KEY, 0);
+}
+
+static void cmp_sem_setup(void)
+{
+    create_sem(CMP_KEY, 0);
+}
+
+/*
+ * Waiting for zero on a zero semaphore needs only read permission
+ */
+static void cmp_sem_read(uint64_t *samples[2])
+{
+    struct sembuf op = { 0, 0, IPC_NOWAIT };
+    int id = attach_sem(O_RDONLY, CMP_KEY, 0);
+    int status = 0;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        CMP_TIME(i, samples[0], status = semop(id, &op, 1));
+        if (status == -1) fail("semop failed");
+    }
+}
+
+static void cmp_sem_teardown(void)
+{
+    close_sem(CMP_KEY, 0);
+}
+
+static void cmp_shm_setup(void)
+{
+    create_shm_v(&seg[0], CMP_KEY, 0);
+}
+
+static void cmp_shm_read(uint64_t *samples[2])
+{
+    struct shared_space_t *segptr = NULL;
+    int id = attach_shm_v(O_RDONLY, &segptr, CMP_KEY, 0);
+    void *p = NULL;
+    int status = 0;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        CMP_TIME(i, samples[0], p = shmat(id, NULL, SHM_RDONLY));
+        if (p == (void *)-1) fail("shmat failed");
+        CMP_TIME(i, samples[1], status = shmdt(p));
+        if (status == -1) fail("shmdt failed");
+    }
+}
+
+static void cmp_shm_teardown(void)
+{
+    close_shm_v(CMP_KEY);
+}
+
+static void cmp_fifo_feed(void)
+{
+    char buf[CMP_RECORD] = BENCH_DATA;
+    int fd = open(CMP_FIFO, O_WRONLY);
+    int i;
+
+    if (fd < 0) fail("open FIFO failed");
+    for (i = 0; i < warmup + iters; i++) {
+        if (write(fd, buf, sizeof(buf)) != sizeof(buf)) fail("write failed");
+    }
+    close(fd);
+}
+
+static void cmp_fifo_read(uint64_t *samples[2])
+{
+    char buf[CMP_RECORD];
+    int fd = open(CMP_FIFO, O_RDONLY);
+    ssize_t n = 0;
+    int i;
+
+    if (fd < 0) fail("open FIFO failed");
+    for (i = -warmup; i < iters; i++) {
+        CMP_TIME(i, samples[0], n = read(fd, buf, sizeof(buf)));
+        if (n != sizeof(buf)) fail("read failed");
+    }
+    close(fd);
+}
+
+static void cmp_file_read(uint64_t *samples[2])
+{
+    char buf[MAX_STRING];
+    ssize_t n = 0;
+    int fd = -1;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        CMP_TIME(i, samples[0], fd = open(CMP_FILE, O_RDONLY));
+        if (fd < 0) fail("open failed");
+        CMP_TIME(i, samples[1], n = read(fd, buf, sizeof(buf)));
+        if (n <= 0) fail("read failed");
+        close(fd);
+    }
+}
+
+static const struct cmp_bench cmp_benches[] = {
+    {"msg",  {"msgrcv", NULL},  CMP_KEY,  cmp_key,  cmp_msg_setup,
+     cmp_msg_feed,  cmp_msg_read,  cmp_msg_teardown, 0},
+    {"msgw", {"msgsnd", NULL},  CMP_KEY,  cmp_key,  cmp_msg_setup,
+     cmp_msg_drain, cmp_msg_write, cmp_msg_teardown, 1},
+    {"sem",  {"semop", NULL},   CMP_KEY,  cmp_key,  cmp_sem_setup,
+     NULL,          cmp_sem_read,  cmp_sem_teardown, 0},
+    {"shm",  {"shmat", "shmdt"}, CMP_KEY, cmp_key,  cmp_shm_setup,
+     NULL,          cmp_shm_read,  cmp_shm_teardown, 0},
+    {"fifo", {"read", NULL},    CMP_FIFO, cmp_fifo, NULL,
+     cmp_fifo_feed, cmp_fifo_read, NULL, 0},
+    {"file", {"open", "read"},  CMP_FILE, cmp_data, NULL,
+     NULL,          cmp_file_read, NULL, 0},
+    {NULL, {NULL, NULL}, NULL, NULL, NULL, NULL, NULL, NULL, 0}
+};
+
+/*
+ * The configurations a bench runs in: a writer stops short of down
+ */
+static int cmp_configs(const struct cmp_bench *b)
+{
+    return b->writes ? CMP_DOWN : CMP_CONFIGS;
+}
+
+static const struct cmp_bench *cmp_find(const char *name)
+{
+    const struct cmp_bench *b;
+
+    for (b = cmp_benches; b->name != NULL; b++) {
+        if (strcmp(b->name, name) == 0) return b;
+    }
+    return NULL;
+}
+
+
+/*
+ * A side of a comparison at a level (-X side): the runner's child after
+ * exec. The reader writes its samples to path, which the runner created.
+ */
+static int cmp_side_main(const char *side, const char *name, const char *path)
+{
+    const struct cmp_bench *b = cmp_find(name);
+    uint64_t *samples[2];
+
+    if (b == NULL) return -1;
+    if (strcmp(side, "setup") == 0) {
+        b->setup();
+    } else if (strcmp(side, "feed") == 0) {
+        pin(cpu_b);
+        b->feed();
+    } else if (strcmp(side, "teardown") == 0) {
+        b->teardown();
+    } else if (strcmp(side, "read") == 0) {
+        pin(cpu_a);
+        alloc_samples(samples, 2);
+        b->read(samples);
+        write_samples(path, samples, b->syscalls[1] ? 2 : 1);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+/*
+ * Run a side at lvl. Returns the child's pid, or -1.
+ */
+static pid_t cmp_spawn(const char *lvl, const char *name, const char *side,
+                       const char *path)
+{
+    const struct level_context *c = level_context(lvl);
+    const struct mode_args *m = find_mode(side);
+    char n[16], w[16], a[16], A[16], s[16], z[24], t[16], T[24];
+    pid_t pid;
+
+    if (c == NULL) return -1;
+    snprintf(t, sizeof(t), "%d", chan_slot_us);
+    snprintf(T, sizeof(T), "%llu", (unsigned long long)chan_start_ns);
+    snprintf(s, sizeof(s), "%d", stream_size);
+    snprintf(z, sizeof(z), "%zu", (m && m->size) ? *m->size : 0);
+    snprintf(n, sizeof(n), "%d", iters);
+    snprintf(w, sizeof(w), "%d", warmup);
+    snprintf(a, sizeof(a), "%d", cpu_a);
+    snprintf(A, sizeof(A), "%d", cpu_b);
+    fflush(NULL);
+    pid = fork();
+    if (pid == 0) {
+        char *argv[] = { (char *)self, "-X", (char *)side, "-b",
+                         (char *)name, "-n", n, "-w", w, "-a", a,
+                         "-A", A, "-s", s, "-z", z, "-x",
+                         (char *)((m && m->opts) ? *m->opts : ""),
+                         "-t", t, "-T", T, "-p", (char *)(path ? path : "-"),
+                         stream_nowait ? "-N" : NULL, NULL };
+
+        if (setexeccon(c->proc) != 0) fail("setexeccon failed");
+        // argv[0] need not be a path; this is the binary that is running
+        execv(SELF_EXE, argv);
+        fail("execv failed");
+    }
+    if (pid == -1) perror("fork failed");
+    return pid;
+}
+
+static int cmp_wait(pid_t pid)
+{
+    int status;
+
+    if (pid == -1) return -1;
+    while (waitpid(pid, &status, 0) == -1) {
+        if (errno != EINTR) return -1;
+    }
+    return (WIFEXITED(status) && WEXITSTATUS(status) == 0) ? 0 : -1;
+}
+
+static int cmp_side(const char *lvl, const char *name, const char *side,
+                    const char *path)
+{
+    return cmp_wait(cmp_spawn(lvl, name, side, path));
+}
+
+/*
+ * Reap two sides that wait on each other, in whichever order they exit.
+ * Once either fails the other would wait for good, so it is killed.
+ */
+static int cmp_wait_pair(pid_t a, pid_t b)
+{
+    pid_t pids[2] = { a, b };
+    int left = 0;
+    int status = 0;
+    int st, i;
+    pid_t pid;
+
+    for (i = 0; i < 2; i++) {
+        if (pids[i] > 0) left++;
+        else status = -1;
+    }
+    while (left > 0) {
+        if (status != 0) {
+            for (i = 0; i < 2; i++) {
+                if (pids[i] > 0) kill(pids[i], SIGKILL);
+            }
+        }
+        pid = waitpid(-1, &st, 0);
+        if (pid == -1) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        for (i = 0; i < 2; i++) {
+            if (pids[i] != pid) continue;
+            pids[i] = -1;
+            left--;
+            if (!WIFEXITED(st) || WEXITSTATUS(st) != 0) status = -1;
+        }
+    }
+    return status;
+}
+
+/*
+ * The runner's own context: every side in this process, the feeder forked
+ */
+static int cmp_in_runner(const struct cmp_bench *b, uint64_t *samples[2])
+{
+    pid_t pid = -1;
+
+    if (b->setup) b->setup();
+    fflush(NULL);
+    if (b->feed) {
+        pid = fork();
+        if (pid == 0) {
+            pin(cpu_b);
+            b->feed();
+            fflush(stdout);
+            _exit(0);
+        }
+        if (pid == -1) return -1;
+    }
+    pin(cpu_a);
+    b->read(samples);
+    if (pid > 0 && cmp_wait(pid) != 0) return -1;
+    if (b->teardown) b->teardown();
+    return 0;
+}
+
+static int cmp_at_level(const struct cmp_bench *b, const char *lvl,
+                        uint64_t *samples[2])
+{
+    char path[MAX_STRING];
+    pid_t feeder = -1;
+    int status = 0;
+
+    snprintf(path, sizeof(path), CMP_SAMPLES, lvl);
+    if (create_file(lvl, path, NULL) != 0) return -1;
+    if (b->setup) status |= cmp_side(lvl_low, b->name, "setup", NULL);
+    if (status == 0 && b->feed) {
+        feeder = cmp_spawn(lvl_low, b->name, "feed", NULL);
+        status |= cmp_wait_pair(feeder,
+                                cmp_spawn(lvl, b->name, "read", path));
+    } else if (status == 0) {
+        status |= cmp_side(lvl, b->name, "read", path);
+    }
+    if (b->teardown) status |= cmp_side(lvl_low, b->name, "teardown", NULL);
+    if (status != 0) return -1;
+    return read_samples(path, samples, b->syscalls[1] ? 2 : 1);
+}
+
+static int run_compare(const struct cmp_bench *b, struct cmp_result *res)
+{
+    uint64_t *samples[2];
+    int status = 0;
+    int config;
+    int k;
+
+    alloc_samples(samples, 2);
+    for (config = 0; config < cmp_configs(b) && status == 0; config++) {
+        fprintf(stderr, "%s %s: %d iterations\n", b->name, cmp_names[config],
+                warmup + iters);
+        if (b->create(b->fixture) != 0) {
+            status = -1;
+            break;
+        }
+        if (config == CMP_RUNNER) {
+            status = cmp_in_runner(b, samples);
+        } else {
+            status = cmp_at_level(b, config == CMP_DOWN ? lvl_high : lvl_low,
+                                  samples);
+        }
+        if (status != 0) {
+            fprintf(stderr, "%s %s failed\n", b->name, cmp_names[config]);
+        }
+        for (k = 0; k < 2 && b->syscalls[k] != NULL && status == 0; k++) {
+            res[k].b = b;
+            res[k].syscall = b->syscalls[k];
+            summarize(samples[k], iters, &res[k].s[config]);
+        }
+        unlink(b->fixture);
+    }
+    free_samples(samples, 2);
+    if (status != 0) return 0;
+    return (b->syscalls[1] != NULL) ? 2 : 1;
+}
+
+
+/*
+ * Each syscall's cost in each configuration, and the differences: same
+ * minus runner is the cost of the confined context, down minus same the
+ * cost of reading across levels
+ */
+static void print_compare(FILE *out, const char *format,
+                          const struct cmp_result *res, int n)
+{
+    struct utsname u;
+    const struct stats *s;
+    int i, c, nc;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "bench,syscall,config,level,kernel,warmup,iterations,"
+                     "mean_ns,p50_ns,p99_ns,p999_ns,min_ns,max_ns,"
+                     "delta_mean_ns,delta_p50_ns\n");
+        for (i = 0; i < n; i++) {
+            for (c = 0; c < cmp_configs(res[i].b); c++) {
+                s = &res[i].s[c];
+                fprintf(out, "%s,%s,%s,%s,%s,%d,%d,%.0f,%.0f,%.0f,%.0f,"
+                        "%.0f,%.0f,%.0f,%.0f\n", res[i].b->name,
+                        res[i].syscall, cmp_names[c],
+                        (c == CMP_DOWN) ? lvl_high : lvl_low, u.release,
+                        warmup, iters, s->mean, s->p50, s->p99, s->p999,
+                        s->min, s->max, s->mean - res[i].s[0].mean,
+                        s->p50 - res[i].s[0].p50);
+            }
+        }
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+        for (i = 0; i < n; i++) {
+            nc = cmp_configs(res[i].b);
+            for (c = 0; c < nc; c++) {
+                s = &res[i].s[c];
+                fprintf(out, "  {\"bench\": \"%s\", \"syscall\": \"%s\", "
+                        "\"config\": \"%s\", \"level\": \"%s\", "
+                        "\"kernel\": \"%s\", \"warmup\": %d, "
+                        "\"iterations\": %d, \"mean_ns\": %.0f, "
+                        "\"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+                        "\"p999_ns\": %.0f, \"min_ns\": %.0f, "
+                        "\"max_ns\": %.0f, \"delta_mean_ns\": %.0f, "
+                        "\"delta_p50_ns\": %.0f}%s\n", res[i].b->name,
+                        res[i].syscall, cmp_names[c],
+                        (c == CMP_DOWN) ? lvl_high : lvl_low, u.release,
+                        warmup, iters, s->mean, s->p50, s->p99, s->p999,
+                        s->min, s->max, s->mean - res[i].s[0].mean,
+                        s->p50 - res[i].s[0].p50,
+                        (i + 1 < n || c + 1 < nc) ? "," : "");
+            }
+        }
+        fprintf(out, "]\n");
+    } else {
+        fprintf(out, "kernel %s, %d iterations after %d; same at %s, "
+                "down at %s\n", u.release, iters, warmup, lvl_low, lvl_high);
+        fprintf(out, "%-12s %9s %9s %9s %11s %11s  (p50 us)\n", "syscall",
+                "runner", "same", "down", "same-runner", "down-same");
+        for (i = 0; i < n; i++) {
+            s = res[i].s;
+            fprintf(out, "%-4s %-7s %9.2f %9.2f", res[i].b->name,
+                    res[i].syscall, s[CMP_RUNNER].p50 / 1e3,
+                    s[CMP_SAME].p50 / 1e3);
+            if (res[i].b->writes) {
+                fprintf(out, " %9s %+11.2f %11s\n", "-",
+                        (s[CMP_SAME].p50 - s[CMP_RUNNER].p50) / 1e3, "-");
+                continue;
+            }
+            fprintf(out, " %9.2f %+11.2f %+11.2f\n", s[CMP_DOWN].p50 / 1e3,
+                    (s[CMP_SAME].p50 - s[CMP_RUNNER].p50) / 1e3,
+                    (s[CMP_DOWN].p50 - s[CMP_SAME].p50) / 1e3);
+        }
+    }
+}
+
+
+/*****************************************************************************
+ * Message stream (-S). A producer at the low level sends a stream of
+ * messages to a queue at that level, and a consumer at the high level
+ * receives them. The payload size doubles from 16 bytes up to msgmax,
+ * once with blocking calls and once with IPC_NOWAIT, yielding between
+ * retries. Each message carries its send time, so the consumer has the
+ * end-to-end latency of every message as well as the rate. The time a
+ * message waits for room in a full queue is part of its latency.
+ */
+
+#define STREAM_MIN    16        // room for the send time, and some
+#define STREAM_MSGMAX "/proc/sys/kernel/msgmax"
+#define STREAM_MSGMNB "/proc/sys/kernel/msgmnb"
+#define STREAM_SIZES  32
+
+struct stream_msg {
+    long mtype;
+    char mtext[];               // the send time, then padding
+};
+
+/* What the consumer passes back, ahead of its latency samples */
+struct stream_head {
+    uint64_t elapsed_ns;        // from the first timed receive to the last
+    uint64_t empty;             // IPC_NOWAIT receives that found no message
+};
+
+struct stream_result {
+    int size;
+    int nowait;
+    double msgs_per_s;
+    double bytes_per_s;
+    double empty_per_msg;
+    struct stats s;             // latency
+};
+
+
+static int stream_limit(const char *path, int dflt)
+{
+    FILE *f = fopen(path, "r");
+    int v = dflt;
+
+    if (f != NULL) {
+        if (fscanf(f, "%d", &v) != 1) v = dflt;
+        fclose(f);
+    }
+    return v;
+}
+
+/*
+ * The largest message: msgmax, but no more than the queue holds
+ */
+static int stream_max(void)
+{
+    int max = stream_limit(STREAM_MSGMAX, 8192);
+    int mnb = stream_limit(STREAM_MSGMNB, 16384);
+
+    return (max < mnb) ? max : mnb;
+}
+
+static struct stream_msg *stream_alloc(void)
+{
+    struct stream_msg *m = calloc(1, sizeof(*m) + stream_size);
+
+    if (m == NULL) fail("malloc failed");
+    m->mtype = 1;
+    return m;
+}
+
+static void stream_produce(void)
+{
+    struct stream_msg *m = stream_alloc();
+    int flags = stream_nowait ? IPC_NOWAIT : 0;
+    int id = attach_msgq(O_WRONLY, CMP_KEY, 0);
+    uint64_t sent;
+    int i;
+
+    pin(cpu_b);
+    for (i = 0; i < warmup + iters; i++) {
+        sent = now_ns();
+        memcpy(m->mtext, &sent, sizeof(sent));
+        while (msgsnd(id, m, stream_size, flags) == -1) {
+            if (errno != EAGAIN && errno != EINTR) fail("msgsnd failed");
+            sched_yield();
+        }
+    }
+    free(m);
+}
+
+static void stream_consume(const char *path)
+{
+    struct stream_msg *m = stream_alloc();
+    struct stream_head head = { 0, 0 };
+    int flags = stream_nowait ? IPC_NOWAIT : 0;
+    int id = attach_msgq(O_RDONLY, CMP_KEY, 0);
+    size_t len = iters * sizeof(uint64_t);
+    uint64_t *lat = malloc(len);
+    uint64_t start = 0, now = 0, sent;
+    int fd;
+    int i;
+
+    if (lat == NULL) fail("malloc failed");
+    pin(cpu_a);
+    for (i = -warmup; i < iters; i++) {
+        if (i == 0) start = now_ns();
+        while (msgrcv(id, m, stream_size, 0, flags) == -1) {
+            if (errno != ENOMSG && errno != EINTR) fail("msgrcv failed");
+            if (i >= 0) head.empty++;
+            sched_yield();
+        }
+        now = now_ns();
+        memcpy(&sent, m->mtext, sizeof(sent));
+        if (i >= 0) lat[i] = now - sent;
+    }
+    head.elapsed_ns = now - start;
+
+    fd = open(path, O_WRONLY | O_TRUNC);
+    if (fd < 0) fail("open samples failed");
+    if (write(fd, &head, sizeof(head)) != sizeof(head) ||
+        write(fd, lat, len) != (ssize_t)len) {
+        fail("write failed");
+    }
+    close(fd);
+    free(lat);
+    free(m);
+}
+
+static int stream_side_main(const char *side, const char *path)
+{
+    if (stream_size < STREAM_MIN) return -1;
+    if (strcmp(side, "produce") == 0) {
+        stream_produce();
+    } else {
+        stream_consume(path);
+    }
+    return 0;
+}
+
+
+/*
+ * One size and mode: the queue, consumer and producer all as in a test
+ */
+static int run_stream(uint64_t *lat, struct stream_result *r)
+{
+    struct stream_head head;
+    char path[MAX_STRING];
+    pid_t consumer, producer;
+    int status = 0;
+    FILE *f;
+
+    fprintf(stderr, "msg stream %d bytes%s: %d messages\n", stream_size,
+            stream_nowait ? ", IPC_NOWAIT" : "", warmup + iters);
+    snprintf(path, sizeof(path), CMP_SAMPLES, lvl_high);
+    if (cmp_key(CMP_KEY) != 0 || create_file(lvl_high, path, NULL) != 0) {
+        return -1;
+    }
+    status |= cmp_side(lvl_low, "msg", "setup", NULL);
+    if (status == 0) {
+        consumer = cmp_spawn(lvl_high, "msg", "consume", path);
+        producer = cmp_spawn(lvl_low, "msg", "produce", NULL);
+        status |= cmp_wait_pair(consumer, producer);
+    }
+    status |= cmp_side(lvl_low, "msg", "teardown", NULL);
+    unlink(CMP_KEY);
+    if (status != 0) return -1;
+
+    if ((f = fopen(path, "r")) == NULL) return -1;
+    if (fread(&head, sizeof(head), 1, f) != 1 ||
+        fread(lat, sizeof(*lat), iters, f) != (size_t)iters) {
+        status = -1;
+    }
+    fclose(f);
+    if (status != 0 || head.elapsed_ns == 0) return -1;
+
+    r->size = stream_size;
+    r->nowait = stream_nowait;
+    r->msgs_per_s = iters * 1e9 / head.elapsed_ns;
+    r->bytes_per_s = r->msgs_per_s * stream_size;
+    r->empty_per_msg = (double)head.empty / iters;
+    summarize(lat, iters, &r->s);
+    return 0;
+}
+
+static void print_stream(FILE *out, const char *format,
+                         const struct stream_result *res, int n)
+{
+    const char *modes[2] = { "block", "nowait" };
+    const struct stream_result *r;
+    struct utsname u;
+    int i;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "bytes,mode,producer,consumer,kernel,warmup,messages,"
+                     "msgs_per_s,bytes_per_s,empty_per_msg,mean_ns,p50_ns,"
+                     "p99_ns,p999_ns,min_ns,max_ns\n");
+        for (i = 0; i < n; i++) {
+            r = &res[i];
+            fprintf(out, "%d,%s,%s,%s,%s,%d,%d,%.0f,%.0f,%.2f,%.0f,%.0f,"
+                    "%.0f,%.0f,%.0f,%.0f\n", r->size, modes[r->nowait],
+                    lvl_low, lvl_high, u.release, warmup, iters,
+                    r->msgs_per_s, r->bytes_per_s, r->empty_per_msg,
+                    r->s.mean, r->s.p50, r->s.p99, r->s.p999, r->s.min,
+                    r->s.max);
+        }
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+        for (i = 0; i < n; i++) {
+            r = &res[i];
+            fprintf(out, "  {\"bytes\": %d, \"mode\": \"%s\", "
+                    "\"producer\": \"%s\", \"consumer\": \"%s\", "
+                    "\"kernel\": \"%s\", \"warmup\": %d, \"messages\": %d, "
+                    "\"msgs_per_s\": %.0f, \"bytes_per_s\": %.0f, "
+                    "\"empty_per_msg\": %.2f, \"mean_ns\": %.0f, "
+                    "\"p50_ns\": %.0f, \"p99_ns\": %.0f, "
+                    "\"p999_ns\": %.0f, \"min_ns\": %.0f, "
+                    "\"max_ns\": %.0f}%s\n", r->size, modes[r->nowait],
+                    lvl_low, lvl_high, u.release, warmup, iters,
+                    r->msgs_per_s, r->bytes_per_s, r->empty_per_msg,
+                    r->s.mean, r->s.p50, r->s.p99, r->s.p999, r->s.min,
+                    r->s.max, (i + 1 < n) ? "," : "");
+        }
+        fprintf(out, "]\n");
+    } else {
+        fprintf(out, "kernel %s, %d messages after %d; producer at %s, "
+                "consumer at %s\n", u.release, iters, warmup, lvl_low,
+                lvl_high);
+        fprintf(out, "%6s %-6s %10s %9s %9s %9s %9s %9s  (latency us)\n",
+                "bytes", "mode", "msgs/s", "MB/s", "p50", "p99", "p99.9",
+                "max");
+        for (i = 0; i < n; i++) {
+            r = &res[i];
+            fprintf(out, "%6d %-6s %10.0f %9.2f %9.2f %9.2f %9.2f %9.2f\n",
+                    r->size, modes[r->nowait], r->msgs_per_s,
+                    r->bytes_per_s / 1e6, r->s.p50 / 1e3, r->s.p99 / 1e3,
+                    r->s.p999 / 1e3, r->s.max / 1e3);
+        }
+    }
+}
+
+/*
+ * Sweep the payload sizes, or run just the one given with -s
+ */
+static int stream_sweep(FILE *out, const char *format)
+{
+    struct stream_result res[2 * STREAM_SIZES];
+    int sizes[STREAM_SIZES];
+    int max = stream_max();
+    uint64_t *lat;
+    int nsizes = 0;
+    int n = 0;
+    int i;
+
+    if (stream_size != 0) {
+        if (stream_size < STREAM_MIN || stream_size > max) {
+            fprintf(stderr, "message size must be %d to %d bytes\n",
+                    STREAM_MIN, max);
+            return -1;
+        }
+        sizes[nsizes++] = stream_size;
+    } else {
+        for (i = STREAM_MIN; i < max && nsizes < STREAM_SIZES - 1; i *= 2) {
+            sizes[nsizes++] = i;
+        }
+        sizes[nsizes++] = max;
+    }
+
+    if ((lat = malloc(iters * sizeof(*lat))) == NULL) fail("malloc failed");
+    for (i = 0; i < nsizes; i++) {
+        stream_size = sizes[i];
+        for (stream_nowait = 0; stream_nowait < 2; stream_nowait++) {
+            if (run_stream(lat, &res[n]) == 0) n++;
+        }
+    }
+    free(lat);
+    if (n == 0) return -1;
+    print_stream(out, format, res, n);
+    return 0;
+}
+
+
+/*****************************************************************************
+ * Shared memory bandwidth (-m). A segment, POSIX and System V, is created
+ * and filled at the low level. A reader then attaches it, reads it all
+ * twice and detaches, -n times. The first pass takes a fault on every
+ * page and the second none, so their difference is the fault cost. The
+ * reader runs at the low level and again at the high level: if the label
+ * check were paid per fault and not just at attach, the high reader's
+ * faults would cost more as well.
+ */
+
+#define BW_SHM      "/mls_bench_bw"
+#define BW_CYCLES   5           // default -n
+#define BW_CHUNK    65536       // read by memcpy, so libc sets the pace
+#define BW_MEMINFO  "/proc/meminfo"
+
+enum bw_time { BW_ATTACH, BW_COLD, BW_WARM, BW_DETACH, BW_TIMES };
+
+struct bw_result {
+    const char *kind;           // "shm" or "shm_v"
+    const char *lvl;            // of the reader
+    size_t size;
+    size_t page;                // of the mapping, for the fault cost;
+                                // 0 when the kernel picks it (THP)
+    struct stats s[BW_TIMES];
+};
+
+static const size_t bw_sizes[] = {
+    4 << 10, 64 << 10, 1 << 20, 16 << 20, 256 << 20, 0
+};
+
+
+static size_t parse_size(const char *arg)
+{
+    char *end;
+    size_t n = strtoull(arg, &end, 10);
+
+    switch (*end) {
+        case 'G': case 'g': n <<= 10;   // fall through
+        case 'M': case 'm': n <<= 10;   // fall through
+        case 'K': case 'k': n <<= 10;
+    }
+    return n;
+}
+
+static const char *format_size(char *buf, size_t len, size_t n)
+{
+    const char *units = "KMG";
+    int u = -1;
+
+    while (u < 2 && n >= 1024 && n % 1024 == 0) {
+        n /= 1024;
+        u++;
+    }
+    if (u < 0) {
+        snprintf(buf, len, "%zu", n);
+    } else {
+        snprintf(buf, len, "%zu%c", n, units[u]);
+    }
+    return buf;
+}
+
+/*
+ * Parse a comma-separated list of options; bit i stands for tokens[i]
+ */
+static int parse_opts(const char *arg, char *const tokens[])
+{
+    char *copy = strdup(arg);
+    char *opts = copy;
+    char *value;
+    int flags = 0;
+    int i;
+
+    while (opts != NULL && *opts != '\0') {
+        if ((i = getsubopt(&opts, tokens, &value)) < 0) {
+            fprintf(stderr, "unknown option '%s'\n", value);
+            flags = -1;
+            break;
+        }
+        flags |= 1 << i;
+    }
+    free(copy);
+    return flags;
+}
+
+static int parse_seg_opts(const char *arg)
+{
+    char *const tokens[] = { "huge", "populate", "lock", NULL };  // SEG_
+
+    return parse_opts(arg, tokens);
+}
+
+static size_t huge_page_size(void)
+{
+    FILE *f = fopen(BW_MEMINFO, "r");
+    char line[MAX_STRING];
+    size_t kb = 2048;
+
+    if (f == NULL) return kb << 10;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "Hugepagesize: %zu kB", &kb) == 1) break;
+    }
+    fclose(f);
+    return kb << 10;
+}
+
+static uint64_t bw_pass(const char *p, size_t size)
+{
+    static char buf[BW_CHUNK];
+    uint64_t start = now_ns();
+    size_t off, n;
+
+    for (off = 0; off < size; off += n) {
+        n = (size - off < BW_CHUNK) ? size - off : BW_CHUNK;
+        memcpy(buf, p + off, n);
+    }
+    __asm__ __volatile__("" : : "r"(buf) : "memory");
+    return now_ns() - start;
+}
+
+
+static void bw_setup(int system_v)
+{
+    struct shared_space_t *segptr = NULL;
+    int fd;
+
+    if (system_v) {
+        create_shm_v_sized(&segptr, CMP_KEY, seg_size, seg_opts, 0);
+        memset(segptr, 0x5a, seg_size);
+        shmdt(segptr);
+    } else {
+        fd = create_shm_sized(&segptr, BW_SHM, seg_size, seg_opts, 0);
+        memset(segptr, 0x5a, seg_size);
+        munmap(segptr, seg_size);
+        close(fd);
+    }
+}
+
+static void bw_read(int system_v, uint64_t *samples[BW_TIMES])
+{
+    struct shared_space_t *segptr = NULL;
+    uint64_t t0, t1, t2;
+    int fd = -1;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        t0 = now_ns();
+        if (system_v) {
+            attach_shm_v_sized(O_RDONLY, &segptr, CMP_KEY, seg_size,
+                               seg_opts, 0);
+        } else {
+            fd = attach_shm_sized(O_RDONLY, &segptr, BW_SHM, seg_size,
+                                  seg_opts, 0);
+        }
+        t1 = now_ns();
+        if (i >= 0) samples[BW_ATTACH][i] = t1 - t0;
+        t2 = bw_pass((const char *)segptr, seg_size);
+        if (i >= 0) samples[BW_COLD][i] = t2;
+        t2 = bw_pass((const char *)segptr, seg_size);
+        if (i >= 0) samples[BW_WARM][i] = t2;
+        t1 = now_ns();
+        if (system_v) {
+            shmdt(segptr);
+        } else {
+            munmap(segptr, seg_size);
+            close(fd);
+        }
+        if (i >= 0) samples[BW_DETACH][i] = now_ns() - t1;
+    }
+}
+
+static void bw_teardown(int system_v)
+{
+    if (system_v) {
+        close_shm_v(CMP_KEY);
+    } else {
+        close_shm(BW_SHM);
+    }
+}
+
+/*
+ * A side of the bandwidth run (-X bw-<side> -b shm|shm_v)
+ */
+static int bw_side_main(const char *side, const char *name, const char *path)
+{
+    int system_v = (strcmp(name, "shm_v") == 0);
+    uint64_t *samples[BW_TIMES];
+
+    if (seg_size == 0 || (seg_opts = parse_seg_opts(seg_optarg)) < 0) {
+        return -1;
+    }
+    if (strcmp(side, "setup") == 0) {
+        bw_setup(system_v);
+    } else if (strcmp(side, "teardown") == 0) {
+        bw_teardown(system_v);
+    } else if (strcmp(side, "read") == 0) {
+        pin(cpu_a);
+        alloc_samples(samples, BW_TIMES);
+        bw_read(system_v, samples);
+        write_samples(path, samples, BW_TIMES);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * One kind and size: created at low, read at low and then at high
+ */
+static int run_bw(const char *kind, uint64_t *samples[BW_TIMES],
+                  struct bw_result *res)
+{
+    const char *lvls[2] = { lvl_low, lvl_high };
+    char path[MAX_STRING];
+    char size[16];
+    int status = 0;
+    int n = 0;
+    int i, k;
+
+    fprintf(stderr, "%s %s: %d passes\n", kind,
+            format_size(size, sizeof(size), seg_size), warmup + iters);
+    if (cmp_key(CMP_KEY) != 0) return 0;
+    status |= cmp_side(lvl_low, kind, "bw-setup", NULL);
+    for (i = 0; i < 2 && status == 0; i++) {
+        snprintf(path, sizeof(path), CMP_SAMPLES, lvls[i]);
+        if (create_file(lvls[i], path, NULL) != 0 ||
+            cmp_side(lvls[i], kind, "bw-read", path) != 0 ||
+            read_samples(path, samples, BW_TIMES) != 0) {
+            status = -1;
+            break;
+        }
+
+        res[n].kind = kind;
+        res[n].lvl = lvls[i];
+        res[n].size = seg_size;
+        // THP may back a POSIX segment with base or huge pages, or both
+        res[n].page = (size_t)sysconf(_SC_PAGESIZE);
+        if (seg_opts & SEG_HUGE) {
+            res[n].page = strcmp(kind, "shm_v") ? 0 : huge_page_size();
+        }
+        for (k = 0; k < BW_TIMES; k++) {
+            summarize(samples[k], iters, &res[n].s[k]);
+        }
+        n++;
+    }
+    status |= cmp_side(lvl_low, kind, "bw-teardown", NULL);
+    unlink(CMP_KEY);
+    if (status != 0) {
+        fprintf(stderr, "%s %s failed\n", kind, size);
+        return 0;
+    }
+    return n;
+}
+
+static void print_bw(FILE *out, const char *format,
+                     const struct bw_result *res, int n)
+{
+    const struct bw_result *r;
+    struct utsname u;
+    double cold, warm, fault;
+    char size[16], per[24];
+    int i;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "kind,bytes,level,options,kernel,warmup,passes,"
+                     "attach_ns,cold_bytes_per_s,warm_bytes_per_s,"
+                     "fault_ns_per_page,page_bytes,detach_ns\n");
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "kernel %s, %d passes after %d, created at %s, "
+                "options '%s'\n", u.release, iters, warmup, lvl_low,
+                seg_optarg);
+        fprintf(out, "%-5s %5s %-6s %10s %9s %9s %11s %10s  (p50)\n",
+                "kind", "size", "level", "attach us", "cold GB/s",
+                "warm GB/s", "fault ns/pg", "detach us");
+    }
+    for (i = 0; i < n; i++) {
+        r = &res[i];
+        // the p50 pass; a fault is what the cold pass costs over the warm
+        cold = r->size / r->s[BW_COLD].p50;
+        warm = r->size / r->s[BW_WARM].p50;
+        fault = 0;
+        per[0] = '\0';
+        if (r->page != 0) {
+            fault = (r->s[BW_COLD].p50 - r->s[BW_WARM].p50) /
+                    ((r->size + r->page - 1) / r->page);
+            snprintf(per, sizeof(per), "%.0f", fault);
+        }
+        if (strcmp(format, "csv") == 0) {
+            fprintf(out, "%s,%zu,%s,\"%s\",%s,%d,%d,%.0f,%.0f,%.0f,%s,%zu,"
+                    "%.0f\n", r->kind, r->size, r->lvl, seg_optarg,
+                    u.release, warmup, iters, r->s[BW_ATTACH].p50,
+                    cold * 1e9, warm * 1e9, per, r->page,
+                    r->s[BW_DETACH].p50);
+        } else if (strcmp(format, "json") == 0) {
+            fprintf(out, "  {\"kind\": \"%s\", \"bytes\": %zu, "
+                    "\"level\": \"%s\", \"options\": \"%s\", "
+                    "\"kernel\": \"%s\", \"warmup\": %d, \"passes\": %d, "
+                    "\"attach_ns\": %.0f, \"cold_bytes_per_s\": %.0f, "
+                    "\"warm_bytes_per_s\": %.0f, "
+                    "\"fault_ns_per_page\": %s, \"page_bytes\": %zu, "
+                    "\"detach_ns\": %.0f}%s\n", r->kind, r->size, r->lvl,
+                    seg_optarg, u.release, warmup, iters,
+                    r->s[BW_ATTACH].p50, cold * 1e9, warm * 1e9,
+                    r->page ? per : "null", r->page, r->s[BW_DETACH].p50,
+                    (i + 1 < n) ? "," : "");
+        } else {
+            if (r->page != 0) snprintf(per, sizeof(per), "%.1f", fault);
+            fprintf(out, "%-5s %5s %-6s %10.2f %9.2f %9.2f %11s %10.2f\n",
+                    r->kind, format_size(size, sizeof(size), r->size),
+                    r->lvl, r->s[BW_ATTACH].p50 / 1e3, cold, warm,
+                    r->page ? per : "-", r->s[BW_DETACH].p50 / 1e3);
+        }
+    }
+    if (strcmp(format, "json") == 0) fprintf(out, "]\n");
+}
+
+/*
+ * Both kinds of segment, at each size or just the one given with -z.
+ * Huge page segments are rounded up to whole huge pages.
+ */
+static int bw_sweep(FILE *out, const char *format)
+{
+    const char *kinds[2] = { "shm", "shm_v" };
+    struct bw_result res[2 * 2 * (sizeof(bw_sizes) / sizeof(bw_sizes[0]))];
+    uint64_t *samples[BW_TIMES];
+    size_t hpage = huge_page_size();
+    size_t only = seg_size;
+    size_t last = 0;
+    int n = 0;
+    int i, j;
+
+    if ((seg_opts = parse_seg_opts(seg_optarg)) < 0) return -1;
+    alloc_samples(samples, BW_TIMES);
+    for (i = 0; only ? i == 0 : bw_sizes[i] != 0; i++) {
+        seg_size = only ? only : bw_sizes[i];
+        if (seg_opts & SEG_HUGE) {
+            seg_size = (seg_size + hpage - 1) / hpage * hpage;
+        }
+        if (seg_size == last) continue;
+        last = seg_size;
+        for (j = 0; j < 2; j++) n += run_bw(kinds[j], samples, &res[n]);
+    }
+    free_samples(samples, BW_TIMES);
+    if (n == 0) return -1;
+    print_bw(out, format, res, n);
+    return 0;
+}
+
+
+/*****************************************************************************
+ * Semaphore latency (-P). Two processes at the same level ping-pong
+ * through a set of two semaphores: A posts ping and waits on pong, B
+ * waits on ping and posts pong. Each side stamps its posts and wakeups,
+ * so the runner has each direction as well as the round trip.
+ *
+ * Across levels there is no ping-pong: posting alters the semaphore,
+ * which the high side may not do to a low set. So the other test is a
+ * one-way signal from a low poster to a waiter at the low level and then
+ * at the high level. The waiter sees the semaphore raised (GETVAL) and
+ * then waits for zero, both reads. The poster sees the waiter queued
+ * (GETZCNT), stamps the time and lowers it. The two waiters' latencies
+ * give the cost of the MLS check on semop.
+ */
+
+#define SEM_SAMPLES  "log/bench.%s.%s.samples"
+#define SEM_UNDO_OPT  0x1       // SEM_UNDO on the operations that alter
+#define SEM_TIMED     0x2       // semtimedop() for the waits
+
+enum sem_dir { SEM_ROUND, SEM_AB, SEM_BA, SEM_ONEWAY, SEM_DIRS };
+
+static const char *sem_dirs[SEM_DIRS] = {
+    "round trip", "a->b", "b->a", "one way"
+};
+
+struct sem_result {
+    const char *test;           // "pingpong" or "signal"
+    const char *from, *to;      // levels
+    int dir;
+    struct stats s;
+};
+
+static int sem_opts = 0;
+
+
+static int parse_sem_opts(const char *arg)
+{
+    char *const tokens[] = { "undo", "timed", NULL };   // SEM_ options
+
+    return parse_opts(arg, tokens);
+}
+
+static void sem_op(int id, int num, int op)
+{
+    struct sembuf sop = { num, op, 0 };
+    struct timespec timeout = { WAIT_DEADLINE_MS / 1000, 0 };
+    int status;
+
+    if (op != 0 && (sem_opts & SEM_UNDO_OPT)) sop.sem_flg |= SEM_UNDO;
+    do {
+        if (sem_opts & SEM_TIMED) {
+            status = semtimedop(id, &sop, 1, &timeout);
+        } else {
+            status = semop(id, &sop, 1);
+        }
+    } while (status == -1 && errno == EINTR);
+    if (status == -1) fail("semop failed");
+}
+
+/*
+ * Bound the next blocking wait: semtimedop() carries its own timeout, a
+ * plain semop() gets SIGALRM, which ends the side so the runner reaps it.
+ */
+static void sem_watchdog(void)
+{
+    if (!(sem_opts & SEM_TIMED)) alarm((WAIT_DEADLINE_MS + 999) / 1000);
+}
+
+/*
+ * Spin until semaphore num reads, through cmd, at least min
+ */
+static void sem_spin(int id, int num, int cmd, int min)
+{
+    struct deadline dl;
+
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    while (semctl(id, num, cmd) < min) {
+        if (deadline_left_ms(&dl) == 0) {
+            errno = ETIMEDOUT;
+            fail("semaphore spin");
+        }
+        sched_yield();
+    }
+}
+
+static void pair_setup(void)
+{
+    create_sem_set(CMP_KEY, 2, 0);
+}
+
+/*
+ * A: post ping, wait for pong. Stamps [0] posts, [1] wakeups.
+ */
+static void pong_a(int id, uint64_t *samples[2])
+{
+    uint64_t posted;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        sem_watchdog();
+        posted = now_ns();
+        sem_op(id, 0, 1);
+        sem_op(id, 1, -1);
+        if (i >= 0) {
+            samples[0][i] = posted;
+            samples[1][i] = now_ns();
+        }
+    }
+    alarm(0);
+}
+
+/*
+ * B: wait for ping, post pong. Stamps [0] the wakeup, which is the post.
+ */
+static void pong_b(int id, uint64_t *samples[1])
+{
+    uint64_t woken;
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        sem_watchdog();
+        sem_op(id, 0, -1);
+        woken = now_ns();
+        sem_op(id, 1, 1);
+        if (i >= 0) samples[0][i] = woken;
+    }
+    alarm(0);
+}
+
+static void signal_post(int id, uint64_t *samples[1])
+{
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        sem_op(id, 0, 1);
+        sem_spin(id, 0, GETZCNT, 1);
+        if (i >= 0) samples[0][i] = now_ns();
+        sem_op(id, 0, -1);
+    }
+}
+
+static void signal_wait(int id, uint64_t *samples[1])
+{
+    int i;
+
+    for (i = -warmup; i < iters; i++) {
+        sem_spin(id, 0, GETVAL, 1);
+        sem_watchdog();
+        sem_op(id, 0, 0);
+        if (i >= 0) samples[0][i] = now_ns();
+    }
+    alarm(0);
+}
+
+/*
+ * A side of the semaphore test (-X sem-<side>)
+ */
+static int sem_side_main(const char *side, const char *path)
+{
+    uint64_t *samples[2];
+    int id;
+
+    if ((sem_opts = parse_sem_opts(sem_optarg)) < 0) return -1;
+    if (strcmp(side, "setup") == 0) {
+        pair_setup();
+        return 0;
+    }
+    if (strcmp(side, "teardown") == 0) {
+        close_sem(CMP_KEY, 0);
+        return 0;
+    }
+
+    // the waiter may be above the set, so it asks only to read
+    id = attach_sem(strcmp(side, "wait") ? O_RDWR : O_RDONLY, CMP_KEY, 0);
+    alloc_samples(samples, 2);
+    if (strcmp(side, "a") == 0) {
+        pin(cpu_a);
+        pong_a(id, samples);
+        write_samples(path, samples, 2);
+    } else if (strcmp(side, "b") == 0) {
+        pin(cpu_b);
+        pong_b(id, samples);
+        write_samples(path, samples, 1);
+    } else if (strcmp(side, "post") == 0) {
+        pin(cpu_a);
+        signal_post(id, samples);
+        write_samples(path, samples, 1);
+    } else if (strcmp(side, "wait") == 0) {
+        pin(cpu_b);
+        signal_wait(id, samples);
+        write_samples(path, samples, 1);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * Start two sides, at their levels, each with its own samples file;
+ * then read back n1 and n2 arrays
+ */
+static int sem_pair(const char *side1, const char *lvl1, uint64_t *s1[],
+                    int n1, const char *side2, const char *lvl2,
+                    uint64_t *s2[], int n2)
+{
+    char path1[MAX_STRING], path2[MAX_STRING];
+    pid_t pid1, pid2;
+    int status = 0;
+
+    snprintf(path1, sizeof(path1), SEM_SAMPLES, lvl1, side1);
+    snprintf(path2, sizeof(path2), SEM_SAMPLES, lvl2, side2);
+    if (cmp_key(CMP_KEY) != 0 ||
+        create_file(lvl1, path1, NULL) != 0 ||
+        create_file(lvl2, path2, NULL) != 0) {
+        return -1;
+    }
+    status |= cmp_side(lvl_low, "sem", "sem-setup", NULL);
+    if (status == 0) {
+        pid1 = cmp_spawn(lvl1, "sem", side1, path1);
+        pid2 = cmp_spawn(lvl2, "sem", side2, path2);
+        status |= cmp_wait_pair(pid1, pid2);
+    }
+    status |= cmp_side(lvl_low, "sem", "sem-teardown", NULL);
+    unlink(CMP_KEY);
+    if (status != 0) return -1;
+    if (read_samples(path1, s1, n1) != 0) return -1;
+    return read_samples(path2, s2, n2);
+}
+
+static void sem_result(struct sem_result *r, const char *test,
+                       const char *from, const char *to, int dir,
+                       uint64_t *delta)
+{
+    r->test = test;
+    r->from = from;
+    r->to = to;
+    r->dir = dir;
+    summarize(delta, iters, &r->s);
+}
+
+static void print_sem(FILE *out, const char *format,
+                      const struct sem_result *res, int n)
+{
+    const struct sem_result *r;
+    struct utsname u;
+    int i;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "test,from,to,direction,options,kernel,warmup,"
+                     "iterations,mean_ns,p50_ns,p99_ns,p999_ns,min_ns,"
+                     "max_ns\n");
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "kernel %s, %d iterations after %d, options '%s'\n",
+                u.release, iters, warmup, sem_optarg);
+        fprintf(out, "%-8s %-5s %-5s %-10s %9s %9s %9s %9s %9s  (us)\n",
+                "test", "from", "to", "direction", "mean", "p50", "p99",
+                "p99.9", "max");
+    }
+    for (i = 0; i < n; i++) {
+        r = &res[i];
+        if (strcmp(format, "csv") == 0) {
+            fprintf(out, "%s,%s,%s,%s,\"%s\",%s,%d,%d,%.0f,%.0f,%.0f,%.0f,"
+                    "%.0f,%.0f\n", r->test, r->from, r->to,
+                    sem_dirs[r->dir], sem_optarg, u.release, warmup, iters,
+                    r->s.mean, r->s.p50, r->s.p99, r->s.p999, r->s.min,
+                    r->s.max);
+        } else if (strcmp(format, "json") == 0) {
+            fprintf(out, "  {\"test\": \"%s\", \"from\": \"%s\", "
+                    "\"to\": \"%s\", \"direction\": \"%s\", "
+                    "\"options\": \"%s\", \"kernel\": \"%s\", "
+                    "\"warmup\": %d, \"iterations\": %d, "
+                    "\"mean_ns\": %.0f, \"p50_ns\": %.0f, "
+                    "\"p99_ns\": %.0f, \"p999_ns\": %.0f, "
+                    "\"min_ns\": %.0f, \"max_ns\": %.0f}%s\n", r->test,
+                    r->from, r->to, sem_dirs[r->dir], sem_optarg,
+                    u.release, warmup, iters, r->s.mean, r->s.p50,
+                    r->s.p99, r->s.p999, r->s.min, r->s.max,
+                    (i + 1 < n) ? "," : "");
+        } else {
+            fprintf(out, "%-8s %-5s %-5s %-10s %9.2f %9.2f %9.2f %9.2f "
+                    "%9.2f\n", r->test, r->from, r->to, sem_dirs[r->dir],
+                    r->s.mean / 1e3, r->s.p50 / 1e3, r->s.p99 / 1e3,
+                    r->s.p999 / 1e3, r->s.max / 1e3);
+        }
+    }
+    if (strcmp(format, "json") == 0) fprintf(out, "]\n");
+}
+
+/*
+ * The ping-pong at the low level, then the signal to low and to high
+ */
+static int sem_latency(FILE *out, const char *format)
+{
+    const char *to[2] = { lvl_low, lvl_high };
+    struct sem_result res[5];
+    uint64_t *a[2], *b[1], *delta[1];
+    int n = 0;
+    int i, j;
+
+    if ((sem_opts = parse_sem_opts(sem_optarg)) < 0) return -1;
+    alloc_samples(a, 2);
+    alloc_samples(b, 1);
+    alloc_samples(delta, 1);
+
+    fprintf(stderr, "sem pingpong at %s: %d iterations\n", lvl_low,
+            warmup + iters);
+    if (sem_pair("sem-a", lvl_low, a, 2, "sem-b", lvl_low, b, 1) == 0) {
+        for (i = 0; i < iters; i++) delta[0][i] = a[1][i] - a[0][i];
+        sem_result(&res[n++], "pingpong", lvl_low, lvl_low, SEM_ROUND,
+                   delta[0]);
+        for (i = 0; i < iters; i++) delta[0][i] = b[0][i] - a[0][i];
+        sem_result(&res[n++], "pingpong", lvl_low, lvl_low, SEM_AB,
+                   delta[0]);
+        for (i = 0; i < iters; i++) delta[0][i] = a[1][i] - b[0][i];
+        sem_result(&res[n++], "pingpong", lvl_low, lvl_low, SEM_BA,
+                   delta[0]);
+    } else {
+        fprintf(stderr, "sem pingpong failed\n");
+    }
+
+    for (j = 0; j < 2; j++) {
+        fprintf(stderr, "sem signal %s to %s: %d iterations\n", lvl_low,
+                to[j], warmup + iters);
+        if (sem_pair("sem-post", lvl_low, a, 1, "sem-wait", to[j], b, 1)) {
+            fprintf(stderr, "sem signal failed\n");
+            continue;
+        }
+        for (i = 0; i < iters; i++) delta[0][i] = b[0][i] - a[0][i];
+        sem_result(&res[n++], "signal", lvl_low, to[j], SEM_ONEWAY,
+                   delta[0]);
+    }
+
+    free_samples(a, 2);
+    free_samples(b, 1);
+    free_samples(delta, 1);
+    if (n == 0) return -1;
+    print_sem(out, format, res, n);
+    return 0;
+}
+
+
+/*****************************************************************************
+ * FIFO throughput (-F). A writer at the low level streams -z bytes a pass
+ * through a low FIFO, -n passes after the warmup, to a reader at the low
+ * level and then at the high level. The writer copies with write(2) or
+ * maps its pages into the pipe with vmsplice(2); the reader copies out
+ * with read(2) or moves the pages to /dev/null with splice(2). Every pass
+ * is timed by the reader, from the end of the one before, so the first
+ * timed pass needs a warmup pass ahead of it.
+ */
+
+#define FIFO_SIZE   (64 << 20)  // default -z
+
+enum fifo_writer { FIFO_WRITE, FIFO_VMSPLICE, FIFO_WRITERS };
+enum fifo_reader { FIFO_READ, FIFO_SPLICE, FIFO_READERS };
+
+static const char *fifo_writers[FIFO_WRITERS] = { "write", "vmsplice" };
+static const char *fifo_readers[FIFO_READERS] = { "read", "splice" };
+
+struct fifo_result {
+    const char *writer;
+    const char *reader;
+    const char *lvl;            // of the reader
+    size_t size;
+    struct stats s;             // ns a pass
+};
+
+
+static int find_name(const char *const names[], int n, const char *name)
+{
+    int i;
+
+    for (i = 0; i < n; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+static void fifo_write(int how)
+{
+    static char buf[BW_CHUNK];
+    struct iovec iov;
+    size_t left = (size_t)(warmup + iters) * fifo_size;
+    ssize_t n;
+    int fd;
+
+    memset(buf, 0x5a, sizeof(buf));
+    if ((fd = open(CMP_FIFO, O_WRONLY)) < 0) fail("open FIFO failed");
+    while (left > 0) {
+        iov.iov_base = buf;
+        iov.iov_len = (left < sizeof(buf)) ? left : sizeof(buf);
+        // the pages are never written again, so they may stay in the pipe
+        if (how == FIFO_VMSPLICE) {
+            n = vmsplice(fd, &iov, 1, 0);
+        } else {
+            n = write(fd, iov.iov_base, iov.iov_len);
+        }
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) continue;
+            fail(how == FIFO_VMSPLICE ? "vmsplice failed" : "write failed");
+        }
+        left -= n;
+    }
+    close(fd);
+}
+
+static void fifo_read(int how, uint64_t *samples[1])
+{
+    static char buf[BW_CHUNK];
+    uint64_t start, end;
+    size_t left;
+    ssize_t n;
+    int null = -1;
+    int fd;
+    int i;
+
+    if ((fd = open(CMP_FIFO, O_RDONLY)) < 0) fail("open FIFO failed");
+    if (how == FIFO_SPLICE && (null = open("/dev/null", O_WRONLY)) < 0) {
+        fail("open /dev/null failed");
+    }
+    start = now_ns();
+    for (i = -warmup; i < iters; i++) {
+        for (left = fifo_size; left > 0; left -= n) {
+            if (how == FIFO_SPLICE) {
+                n = splice(fd, NULL, null, NULL,
+                           (left < sizeof(buf)) ? left : sizeof(buf),
+                           SPLICE_F_MOVE);
+            } else {
+                n = read(fd, buf, (left < sizeof(buf)) ? left : sizeof(buf));
+            }
+            if (n < 0 && errno == EINTR) {
+                n = 0;
+            } else if (n <= 0) {
+                fail(how == FIFO_SPLICE ? "splice failed" : "read failed");
+            }
+        }
+        end = now_ns();
+        if (i >= 0) samples[0][i] = end - start;
+        start = end;
+    }
+    if (null >= 0) close(null);
+    close(fd);
+}
+
+/*
+ * A side of the FIFO run (-X fifo-write -b write|vmsplice, or
+ * -X fifo-read -b read|splice)
+ */
+static int fifo_side_main(const char *side, const char *name,
+                          const char *path)
+{
+    uint64_t *samples[1];
+    int how;
+
+    if (fifo_size == 0) return -1;
+    if (strcmp(side, "write") == 0) {
+        if ((how = find_name(fifo_writers, FIFO_WRITERS, name)) < 0) {
+            return -1;
+        }
+        pin(cpu_b);
+        fifo_write(how);
+    } else if (strcmp(side, "read") == 0) {
+        if ((how = find_name(fifo_readers, FIFO_READERS, name)) < 0) {
+            return -1;
+        }
+        pin(cpu_a);
+        alloc_samples(samples, 1);
+        fifo_read(how, samples);
+        write_samples(path, samples, 1);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * One writer and reader pair, with the reader at lvl
+ */
+static int run_fifo(int writer, int reader, const char *lvl,
+                    uint64_t *samples[1], struct fifo_result *r)
+{
+    char path[MAX_STRING];
+    pid_t pid;
+    int status = 0;
+
+    fprintf(stderr, "fifo %s to %s at %s: %d passes\n",
+            fifo_writers[writer], fifo_readers[reader], lvl,
+            warmup + iters);
+    snprintf(path, sizeof(path), CMP_SAMPLES, lvl);
+    if (cmp_fifo(CMP_FIFO) != 0 || create_file(lvl, path, NULL) != 0) {
+        return 0;
+    }
+    pid = cmp_spawn(lvl_low, fifo_writers[writer], "fifo-write", NULL);
+    status |= cmp_wait_pair(pid, cmp_spawn(lvl, fifo_readers[reader],
+                                           "fifo-read", path));
+    unlink(CMP_FIFO);
+    if (status != 0 || read_samples(path, samples, 1) != 0) {
+        fprintf(stderr, "fifo %s to %s at %s failed\n",
+                fifo_writers[writer], fifo_readers[reader], lvl);
+        return 0;
+    }
+
+    r->writer = fifo_writers[writer];
+    r->reader = fifo_readers[reader];
+    r->lvl = lvl;
+    r->size = fifo_size;
+    summarize(samples[0], iters, &r->s);
+    return 1;
+}
+
+static void print_fifo(FILE *out, const char *format,
+                       const struct fifo_result *res, int n)
+{
+    const struct fifo_result *r;
+    struct utsname u;
+    double p50, worst;
+    char size[16];
+    int i;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "writer,reader,level,bytes,kernel,warmup,passes,"
+                     "p50_bytes_per_s,worst_bytes_per_s,p50_ns,max_ns\n");
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "kernel %s, %d passes of %s after %d, written at %s\n",
+                u.release, iters, format_size(size, sizeof(size), fifo_size),
+                warmup, lvl_low);
+        fprintf(out, "%-8s %-6s %-6s %10s %10s\n", "writer", "reader",
+                "level", "p50 MB/s", "worst MB/s");
+    }
+    for (i = 0; i < n; i++) {
+        r = &res[i];
+        p50 = r->size / r->s.p50 * 1e9;
+        worst = r->size / r->s.max * 1e9;
+        if (strcmp(format, "csv") == 0) {
+            fprintf(out, "%s,%s,%s,%zu,%s,%d,%d,%.0f,%.0f,%.0f,%.0f\n",
+                    r->writer, r->reader, r->lvl, r->size, u.release,
+                    warmup, iters, p50, worst, r->s.p50, r->s.max);
+        } else if (strcmp(format, "json") == 0) {
+            fprintf(out, "  {\"writer\": \"%s\", \"reader\": \"%s\", "
+                    "\"level\": \"%s\", \"bytes\": %zu, "
+                    "\"kernel\": \"%s\", \"warmup\": %d, \"passes\": %d, "
+                    "\"p50_bytes_per_s\": %.0f, "
+                    "\"worst_bytes_per_s\": %.0f, \"p50_ns\": %.0f, "
+                    "\"max_ns\": %.0f}%s\n", r->writer, r->reader, r->lvl,
+                    r->size, u.release, warmup, iters, p50, worst,
+                    r->s.p50, r->s.max, (i + 1 < n) ? "," : "");
+        } else {
+            fprintf(out, "%-8s %-6s %-6s %10.1f %10.1f\n", r->writer,
+                    r->reader, r->lvl, p50 / 1e6, worst / 1e6);
+        }
+    }
+    if (strcmp(format, "json") == 0) fprintf(out, "]\n");
+}
+
+/*
+ * Every writer and reader pair, with the reader at low and then at high
+ */
+static int fifo_throughput(FILE *out, const char *format)
+{
+    const char *lvls[2] = { lvl_low, lvl_high };
+    struct fifo_result res[FIFO_WRITERS * FIFO_READERS * 2];
+    uint64_t *samples[1];
+    int n = 0;
+    int w, r, i;
+
+    if (fifo_size == 0) fifo_size = FIFO_SIZE;
+    alloc_samples(samples, 1);
+    for (w = 0; w < FIFO_WRITERS; w++) {
+        for (r = 0; r < FIFO_READERS; r++) {
+            for (i = 0; i < 2; i++) {
+                n += run_fifo(w, r, lvls[i], samples, &res[n]);
+            }
+        }
+    }
+    free_samples(samples, 1);
+    if (n == 0) return -1;
+    print_fifo(out, format, res, n);
+    return 0;
+}
+
+
+/*****************************************************************************
+ * File reads (-R). A file of -z bytes (default 64M) is created and filled
+ * at the low level, like the test fixtures, and read whole at the low
+ * level and then at the high level, -n passes after the warmup. Each path
+ * reads it in order, 64K at a time, and in a random order, 4K at a time:
+ *
+ *   read    pread(2) through the page cache
+ *   mmap    mapped, copied out and unmapped each pass
+ *   direct  pread(2) on an O_DIRECT descriptor
+ *   uring   io_uring reads, FILE_DEPTH in flight, by raw syscalls
+ *
+ * A pass of open is FILE_OPENS open(2) and close(2) pairs. Every row gives
+ * the time per operation next to the throughput, so a label check paid on
+ * each read shows up against one paid only on open or mmap.
+ */
+
+#define FILE_SIZE   (64 << 20)  // default -z
+#define FILE_BLOCK  4096        // random reads, and O_DIRECT alignment
+#define FILE_OPENS  1000
+#define FILE_DEPTH  32
+
+enum file_path { FILE_READ, FILE_MMAP, FILE_DIRECT, FILE_URING, FILE_OPEN,
+                 FILE_PATHS };
+enum file_access { FILE_SEQ, FILE_RAND, FILE_ACCESSES };
+
+static const char *file_paths[FILE_PATHS] = {
+    "read", "mmap", "direct", "uring", "open"
+};
+static const char *file_accesses[FILE_ACCESSES] = { "seq", "rand" };
+
+struct file_result {
+    const char *path;
+    const char *access;
+    const char *lvl;            // of the reader
+    size_t bytes;               // a pass; 0 for open
+    size_t ops;                 // a pass
+    struct stats s;             // ns a pass
+};
+
+/* What a pass reads: ops chunks, at the offsets in off[] */
+struct file_pass {
+    size_t chunk;
+    size_t ops;
+    off_t *off;
+};
+
+
+static void file_fill(size_t size)
+{
+    static char buf[BW_CHUNK];
+    size_t left;
+    int fd;
+
+    memset(buf, 0x5a, sizeof(buf));
+    if ((fd = open(CMP_FILE, O_WRONLY | O_TRUNC)) < 0) fail("open failed");
+    for (left = size; left > 0; left -= sizeof(buf)) {
+        if (write(fd, buf, sizeof(buf)) != sizeof(buf)) fail("write failed");
+    }
+    if (fsync(fd) != 0) fail("fsync failed");
+    close(fd);
+}
+
+/*
+ * The offsets of a pass; a random pass visits every block once, in the
+ * same order at every level
+ */
+static void file_plan(int access, struct file_pass *p)
+{
+    off_t t;
+    size_t i, j;
+
+    p->chunk = (access == FILE_SEQ) ? BW_CHUNK : FILE_BLOCK;
+    p->ops = file_size / p->chunk;
+    p->off = malloc(p->ops * sizeof(p->off[0]));
+    if (p->off == NULL) fail("malloc failed");
+    for (i = 0; i < p->ops; i++) p->off[i] = (off_t)i * p->chunk;
+    if (access == FILE_SEQ) return;
+    srand(1);
+    for (i = p->ops - 1; i > 0; i--) {
+        j = rand() % (i + 1);
+        t = p->off[i];
+        p->off[i] = p->off[j];
+        p->off[j] = t;
+    }
+}
+
+static void file_pread(int fd, char *buf, const struct file_pass *p)
+{
+    size_t i;
+
+    for (i = 0; i < p->ops; i++) {
+        if (pread(fd, buf, p->chunk, p->off[i]) != (ssize_t)p->chunk) {
+            fail("pread failed");
+        }
+    }
+}
+
+static void file_mmap(int fd, char *buf, const struct file_pass *p)
+{
+    char *map = mmap(NULL, file_size, PROT_READ, MAP_SHARED, fd, 0);
+    size_t i;
+
+    if (map == MAP_FAILED) fail("mmap failed");
+    for (i = 0; i < p->ops; i++) memcpy(buf, map + p->off[i], p->chunk);
+    __asm__ __volatile__("" : : "r"(buf) : "memory");
+    munmap(map, file_size);
+}
+
+static void file_open(void)
+{
+    int fd;
+    int i;
+
+    for (i = 0; i < FILE_OPENS; i++) {
+        if ((fd = open(CMP_FILE, O_RDONLY)) < 0) fail("open failed");
+        close(fd);
+    }
+}
+
+
+#ifdef __NR_io_uring_setup
+/* The rings of an io_uring instance, as mapped from its fd */
+struct file_uring {
+    int fd;
+    unsigned *sq_tail, *sq_mask, *sq_array;
+    unsigned *cq_head, *cq_tail, *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+};
+
+static void uring_init(struct file_uring *u)
+{
+    struct io_uring_params p;
+    size_t sq_len, cq_len;
+    char *sq, *cq;
+
+    memset(&p, 0, sizeof(p));
+    u->fd = syscall(__NR_io_uring_setup, FILE_DEPTH, &p);
+    if (u->fd < 0) fail("io_uring_setup failed");
+    sq_len = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+    cq_len = p.cq_off.cqes + p.cq_entries * sizeof(struct io_uring_cqe);
+    if ((p.features & IORING_FEAT_SINGLE_MMAP) && cq_len > sq_len) {
+        sq_len = cq_len;
+    }
+    sq = mmap(NULL, sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+              u->fd, IORING_OFF_SQ_RING);
+    if (sq == MAP_FAILED) fail("mmap SQ ring failed");
+    cq = sq;
+    if (!(p.features & IORING_FEAT_SINGLE_MMAP)) {
+        cq = mmap(NULL, cq_len, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_POPULATE, u->fd, IORING_OFF_CQ_RING);
+        if (cq == MAP_FAILED) fail("mmap CQ ring failed");
+    }
+    u->sqes = mmap(NULL, p.sq_entries * sizeof(struct io_uring_sqe),
+                   PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, u->fd,
+                   IORING_OFF_SQES);
+    if (u->sqes == MAP_FAILED) fail("mmap SQEs failed");
+    u->sq_tail = (unsigned *)(sq + p.sq_off.tail);
+    u->sq_mask = (unsigned *)(sq + p.sq_off.ring_mask);
+    u->sq_array = (unsigned *)(sq + p.sq_off.array);
+    u->cq_head = (unsigned *)(cq + p.cq_off.head);
+    u->cq_tail = (unsigned *)(cq + p.cq_off.tail);
+    u->cq_mask = (unsigned *)(cq + p.cq_off.ring_mask);
+    u->cqes = (struct io_uring_cqe *)(cq + p.cq_off.cqes);
+}
+
+/*
+ * Keep FILE_DEPTH reads in flight until the pass is done. The data is
+ * never looked at, so the reads share FILE_DEPTH buffers by position.
+ */
+static void file_uring(struct file_uring *u, int fd, char *buf,
+                       const struct file_pass *p)
+{
+    struct io_uring_sqe *sqe;
+    struct io_uring_cqe *cqe;
+    unsigned tail, head, queued;
+    size_t next = 0, done = 0;
+    int inflight = 0;
+    int n;
+
+    while (done < p->ops) {
+        tail = *u->sq_tail;
+        for (queued = 0; inflight < FILE_DEPTH && next < p->ops; queued++) {
+            sqe = &u->sqes[tail & *u->sq_mask];
+            memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = fd;
+            sqe->addr = (uintptr_t)(buf + (next % FILE_DEPTH) * p->chunk);
+            sqe->len = p->chunk;
+            sqe->off = p->off[next++];
+            u->sq_array[tail & *u->sq_mask] = tail & *u->sq_mask;
+            tail++;
+            inflight++;
+        }
+        __atomic_store_n(u->sq_tail, tail, __ATOMIC_RELEASE);
+        n = syscall(__NR_io_uring_enter, u->fd, queued, 1,
+                    IORING_ENTER_GETEVENTS, NULL, 0);
+        if (n < 0 && errno != EINTR) fail("io_uring_enter failed");
+
+        head = *u->cq_head;
+        while (head != __atomic_load_n(u->cq_tail, __ATOMIC_ACQUIRE)) {
+            cqe = &u->cqes[head & *u->cq_mask];
+            if (cqe->res != (int)p->chunk) {
+                errno = (cqe->res < 0) ? -cqe->res : EIO;
+                fail("io_uring read failed");
+            }
+            head++;
+            done++;
+            inflight--;
+        }
+        __atomic_store_n(u->cq_head, head, __ATOMIC_RELEASE);
+    }
+}
+#endif
+
+static void file_read(int path, int access, uint64_t *samples[1])
+{
+#ifdef __NR_io_uring_setup
+    struct file_uring u;
+#endif
+    struct file_pass p = { 0, 0, NULL };
+    uint64_t start;
+    char *buf;
+    int fd = -1;
+    int i;
+
+    if (posix_memalign((void **)&buf, FILE_BLOCK, FILE_DEPTH * BW_CHUNK)) {
+        fail("posix_memalign failed");
+    }
+    if (path != FILE_OPEN) {
+        file_plan(access, &p);
+        fd = open(CMP_FILE, O_RDONLY | (path == FILE_DIRECT ? O_DIRECT : 0));
+        if (fd < 0) fail("open failed");
+    }
+#ifdef __NR_io_uring_setup
+    if (path == FILE_URING) uring_init(&u);
+#else
+    if (path == FILE_URING) {
+        errno = ENOSYS;
+        fail("io_uring is not supported");
+    }
+#endif
+
+    for (i = -warmup; i < iters; i++) {
+        start = now_ns();
+        switch (path) {
+            case FILE_READ:
+            case FILE_DIRECT:
+                file_pread(fd, buf, &p);
+                break;
+            case FILE_MMAP:
+                file_mmap(fd, buf, &p);
+                break;
+#ifdef __NR_io_uring_setup
+            case FILE_URING:
+                file_uring(&u, fd, buf, &p);
+                break;
+#endif
+            case FILE_OPEN:
+                file_open();
+                break;
+        }
+        if (i >= 0) samples[0][i] = now_ns() - start;
+    }
+    if (fd >= 0) close(fd);
+    free(p.off);
+    free(buf);
+}
+
+/*
+ * A side of the file run (-X file-fill, or -X file-seq|file-rand -b path)
+ */
+static int file_side_main(const char *side, const char *name,
+                          const char *path)
+{
+    uint64_t *samples[1];
+    int how, access;
+
+    if (file_size == 0) return -1;
+    if (strcmp(side, "fill") == 0) {
+        file_fill(file_size);
+        return 0;
+    }
+    if ((how = find_name(file_paths, FILE_PATHS, name)) < 0 ||
+        (access = find_name(file_accesses, FILE_ACCESSES, side)) < 0) {
+        return -1;
+    }
+    pin(cpu_a);
+    alloc_samples(samples, 1);
+    file_read(how, access, samples);
+    write_samples(path, samples, 1);
+    return 0;
+}
+
+
+/*
+ * One path and access pattern, with the reader at lvl
+ */
+static int run_file(int how, int access, const char *lvl,
+                    uint64_t *samples[1], struct file_result *r)
+{
+    char path[MAX_STRING];
+    char side[16];
+
+    fprintf(stderr, "file %s %s at %s: %d passes\n", file_paths[how],
+            file_accesses[access], lvl, warmup + iters);
+    snprintf(path, sizeof(path), CMP_SAMPLES, lvl);
+    snprintf(side, sizeof(side), "file-%s", file_accesses[access]);
+    if (create_file(lvl, path, NULL) != 0 ||
+        cmp_side(lvl, file_paths[how], side, path) != 0 ||
+        read_samples(path, samples, 1) != 0) {
+        fprintf(stderr, "file %s %s at %s failed\n", file_paths[how],
+                file_accesses[access], lvl);
+        return 0;
+    }
+
+    r->path = file_paths[how];
+    r->access = (how == FILE_OPEN) ? "-" : file_accesses[access];
+    r->lvl = lvl;
+    r->bytes = (how == FILE_OPEN) ? 0 : file_size;
+    r->ops = (how == FILE_OPEN) ? FILE_OPENS :
+             file_size / ((access == FILE_SEQ) ? BW_CHUNK : FILE_BLOCK);
+    summarize(samples[0], iters, &r->s);
+    return 1;
+}
+
+static void print_file(FILE *out, const char *format,
+                       const struct file_result *res, int n)
+{
+    const struct file_result *r;
+    struct utsname u;
+    double p50, worst, op;
+    char size[16];
+    int i;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "path,access,level,bytes,ops,kernel,warmup,passes,"
+                     "p50_bytes_per_s,worst_bytes_per_s,p50_ns_per_op,"
+                     "p50_ns,max_ns\n");
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "kernel %s, %d passes of %s after %d, created at %s\n",
+                u.release, iters, format_size(size, sizeof(size), file_size),
+                warmup, lvl_low);
+        fprintf(out, "%-6s %-6s %-6s %10s %10s %10s\n", "path", "access",
+                "level", "p50 MB/s", "worst MB/s", "ns/op");
+    }
+    for (i = 0; i < n; i++) {
+        r = &res[i];
+        p50 = r->bytes / r->s.p50 * 1e9;
+        worst = r->bytes / r->s.max * 1e9;
+        op = r->s.p50 / r->ops;
+        if (strcmp(format, "csv") == 0) {
+            fprintf(out, "%s,%s,%s,%zu,%zu,%s,%d,%d,%.0f,%.0f,%.0f,%.0f,"
+                    "%.0f\n", r->path, r->access, r->lvl, r->bytes, r->ops,
+                    u.release, warmup, iters, p50, worst, op, r->s.p50,
+                    r->s.max);
+        } else if (strcmp(format, "json") == 0) {
+            fprintf(out, "  {\"path\": \"%s\", \"access\": \"%s\", "
+                    "\"level\": \"%s\", \"bytes\": %zu, \"ops\": %zu, "
+                    "\"kernel\": \"%s\", \"warmup\": %d, \"passes\": %d, "
+                    "\"p50_bytes_per_s\": %.0f, "
+                    "\"worst_bytes_per_s\": %.0f, "
+                    "\"p50_ns_per_op\": %.0f, \"p50_ns\": %.0f, "
+                    "\"max_ns\": %.0f}%s\n", r->path, r->access, r->lvl,
+                    r->bytes, r->ops, u.release, warmup, iters, p50, worst,
+                    op, r->s.p50, r->s.max, (i + 1 < n) ? "," : "");
+        } else if (r->bytes == 0) {
+            fprintf(out, "%-6s %-6s %-6s %10s %10s %10.0f\n", r->path,
+                    r->access, r->lvl, "-", "-", op);
+        } else {
+            fprintf(out, "%-6s %-6s %-6s %10.1f %10.1f %10.0f\n", r->path,
+                    r->access, r->lvl, p50 / 1e6, worst / 1e6, op);
+        }
+    }
+    if (strcmp(format, "json") == 0) fprintf(out, "]\n");
+}
+
+/*
+ * Every path (or just -b path) and access pattern, with the reader at low
+ * and then at high. The file is a whole number of 64K chunks.
+ */
+static int file_throughput(FILE *out, const char *format, const char *only)
+{
+    const char *lvls[2] = { lvl_low, lvl_high };
+    struct file_result res[FILE_PATHS * FILE_ACCESSES * 2];
+    uint64_t *samples[1];
+    int n = 0;
+    int how, access, i;
+
+    if (file_size == 0) file_size = FILE_SIZE;
+    file_size = (file_size + BW_CHUNK - 1) / BW_CHUNK * BW_CHUNK;
+    if (create_file(lvl_low, CMP_FILE, NULL) != 0 ||
+        cmp_side(lvl_low, "file", "file-fill", NULL) != 0) {
+        fprintf(stderr, "file fixture failed\n");
+        return -1;
+    }
+    alloc_samples(samples, 1);
+    for (how = 0; how < FILE_PATHS; how++) {
+        if (only != NULL && strcmp(only, file_paths[how]) != 0) continue;
+        for (access = 0; access < FILE_ACCESSES; access++) {
+            // open has no access pattern
+            if (how == FILE_OPEN && access != FILE_SEQ) continue;
+            for (i = 0; i < 2; i++) {
+                n += run_file(how, access, lvls[i], samples, &res[n]);
+            }
+        }
+    }
+    free_samples(samples, 1);
+    unlink(CMP_FILE);
+    if (n == 0) return -1;
+    print_file(out, format, res, n);
+    return 0;
+}
+
+
+/*****************************************************************************
+ * Covert timing channels (-C). A sender at the high level leaks bits to a
+ * receiver at the low level through a resource both may use, in slots of
+ * -t us starting at a time the runner sets. In a 1 slot the sender loads
+ * the resource and in a 0 slot it sleeps; the receiver measures what is
+ * left for it:
+ *
+ *   cpu    both pinned to one cpu; the receiver counts its loop turns
+ *   cache  the sender reads page k of a cold low file (read-down); the
+ *          receiver times its own read of page k late in the slot
+ *   sem    the sender reads a low semaphore set with GETVAL; the receiver
+ *          counts its wait-for-zero semops on it
+ *   msg    the sender creates and removes queues at its own level; the
+ *          receiver counts IPC_STATs of its low queue
+ *
+ * The first -w of the -n slots are a 0101... preamble. The receiver's
+ * threshold is midway between the preamble's 0 and 1 medians, and the rest
+ * of the slots, a fixed pseudo-random message, are decoded against it.
+ * The capacity of a slot length is its raw rate times 1 - H(e), H being
+ * the binary entropy of the bit error rate e.
+ */
+
+#define CHAN_BITS   256         // default -n
+#define CHAN_SYNC   32          // default -w
+#define CHAN_LEAD   (500 * 1000000ULL)  // for both sides to start
+
+enum chan_kind { CHAN_CPU, CHAN_CACHE, CHAN_SEM, CHAN_MSG, CHAN_KINDS };
+
+static const char *chan_names[CHAN_KINDS] = { "cpu", "cache", "sem", "msg" };
+
+static const int chan_slots[] = { 10000, 5000, 2000, 1000, 500, 200, 100, 0 };
+
+struct chan_result {
+    const char *name;
+    int slot_us;
+    int bits;                   // decoded, after the preamble
+    int errors;
+    double p50[2];              // of the preamble's 0s and 1s
+    double raw, capacity;       // bits/s
+};
+
+
+/*
+ * Bit i of a fixed pseudo-random message
+ */
+static int message_bit(int i)
+{
+    uint32_t x = (uint32_t)i * 2654435761U;
+
+    x ^= x >> 15;
+    return (x >> 7) & 1;
+}
+
+/*
+ * Bit i of the preamble and message, which both sides know
+ */
+static int chan_bit(int i)
+{
+    return (i < warmup) ? (i & 1) : message_bit(i);
+}
+
+static void sleep_until(uint64_t ns)
+{
+    struct timespec ts = { ns / 1000000000ULL, ns % 1000000000ULL };
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) ==
+           EINTR)
+        ;
+}
+
+static int chan_file(int fd)
+{
+    // no readahead: a read must bring in just its own page
+    errno = posix_fadvise(fd, 0, 0, POSIX_FADV_RANDOM);
+    if (errno != 0) fail("posix_fadvise failed");
+    return fd;
+}
+
+/*
+ * The cache channel's file: -z, or a page a slot, in whole 64K chunks
+ */
+static size_t chan_file_size(void)
+{
+    size_t size = chan_size ? chan_size : (size_t)iters * FILE_BLOCK;
+
+    return (size + BW_CHUNK - 1) / BW_CHUNK * BW_CHUNK;
+}
+
+/*
+ * The low fixture: a file of one page a slot, out of the page cache; or a
+ * semaphore set or a queue
+ */
+static void chan_setup(int kind)
+{
+    int fd;
+
+    if (kind == CHAN_CACHE) {
+        file_fill(chan_file_size());
+        if ((fd = open(CMP_FILE, O_RDONLY)) < 0) fail("open failed");
+        errno = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+        if (errno != 0) fail("posix_fadvise failed");
+        close(fd);
+    } else if (kind == CHAN_SEM) {
+        create_sem_set(CMP_KEY, 1, 0);
+    } else if (kind == CHAN_MSG) {
+        create_msgq(CMP_KEY, 0);
+    }
+}
+
+static void chan_teardown(int kind)
+{
+    if (kind == CHAN_SEM) {
+        close_sem(CMP_KEY, 0);
+    } else if (kind == CHAN_MSG) {
+        close_msgq(CMP_KEY, 0);
+    }
+}
+
+static void chan_send(int kind)
+{
+    uint64_t slot = chan_slot_us * 1000ULL;
+    uint64_t start, end;
+    char c;
+    int fd = -1, id = -1, q;
+    int i;
+
+    if (kind == CHAN_CACHE) {
+        fd = chan_file(open(CMP_FILE, O_RDONLY));
+    } else if (kind == CHAN_SEM) {
+        id = attach_sem(O_RDONLY, CMP_KEY, 0);
+    }
+    for (i = 0; i < iters; i++) {
+        start = chan_start_ns + i * slot;
+        end = start + slot;
+        sleep_until(start);
+        if (!chan_bit(i)) continue;
+        if (kind == CHAN_CACHE) {
+            if (pread(fd, &c, 1, (off_t)i * FILE_BLOCK) != 1) {
+                fail("pread failed");
+            }
+            continue;
+        }
+        while (now_ns() < end) {
+            if (kind == CHAN_SEM) {
+                semctl(id, 0, GETVAL);
+            } else if (kind == CHAN_MSG) {
+                q = msgget(IPC_PRIVATE, IPC_CREAT | 0600);
+                if (q < 0) fail("msgget failed");
+                msgctl(q, IPC_RMID, NULL);
+            }
+        }
+    }
+    if (fd >= 0) close(fd);
+}
+
+/*
+ * Measure each slot, leaving an eighth at either end for clock skew
+ */
+static void chan_recv(int kind, uint64_t *samples[1])
+{
+    uint64_t slot = chan_slot_us * 1000ULL;
+    struct sembuf zero = { 0, 0, 0 };
+    struct msqid_ds ds;
+    uint64_t start, end, t;
+    uint64_t n;
+    char c;
+    int fd = -1, id = -1;
+    int i;
+
+    if (kind == CHAN_CACHE) {
+        fd = chan_file(open(CMP_FILE, O_RDONLY));
+    } else if (kind == CHAN_SEM) {
+        id = attach_sem(O_RDONLY, CMP_KEY, 0);
+    } else if (kind == CHAN_MSG) {
+        id = attach_msgq(O_RDONLY, CMP_KEY, 0);
+    }
+    for (i = 0; i < iters; i++) {
+        start = chan_start_ns + i * slot;
+        end = start + slot - slot / 8;
+        if (kind == CHAN_CACHE) {
+            sleep_until(start + slot / 2);
+            t = now_ns();
+            if (pread(fd, &c, 1, (off_t)i * FILE_BLOCK) != 1) {
+                fail("pread failed");
+            }
+            samples[0][i] = now_ns() - t;
+            continue;
+        }
+        sleep_until(start + slot / 8);
+        for (n = 0; now_ns() < end; n++) {
+            if (kind == CHAN_SEM) {
+                semop(id, &zero, 1);
+            } else if (kind == CHAN_MSG) {
+                msgctl(id, IPC_STAT, &ds);
+            }
+        }
+        samples[0][i] = n;
+    }
+    if (fd >= 0) close(fd);
+}
+
+/*
+ * A side of a channel (-X chan-<side> -b kind -t slot -T start)
+ */
+static int chan_side_main(const char *side, const char *name,
+                          const char *path)
+{
+    uint64_t *samples[1];
+    int kind = find_name(chan_names, CHAN_KINDS, name);
+
+    if (kind < 0) return -1;
+    if (strcmp(side, "setup") == 0) {
+        chan_setup(kind);
+    } else if (strcmp(side, "teardown") == 0) {
+        chan_teardown(kind);
+    } else if (strcmp(side, "send") == 0) {
+        pin(cpu_b);
+        chan_send(kind);
+    } else if (strcmp(side, "recv") == 0) {
+        pin(cpu_a);
+        alloc_samples(samples, 1);
+        chan_recv(kind, samples);
+        write_samples(path, samples, 1);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+static double entropy(double p)
+{
+    if (p <= 0 || p >= 1) return 0;
+    return -p * log2(p) - (1 - p) * log2(1 - p);
+}
+
+/*
+ * Calibrate on the preamble, decode the message and count the errors. The
+ * threshold is between the medians, since a cold read or a preemption
+ * can be a hundred times the usual slot.
+ */
+static void chan_decode(const uint64_t *m, struct chan_result *r)
+{
+    uint64_t *v[2];
+    int n[2] = { 0, 0 };
+    double mid;
+    int up;
+    int i, b;
+
+    v[0] = malloc(warmup * sizeof(uint64_t));
+    v[1] = malloc(warmup * sizeof(uint64_t));
+    if (v[0] == NULL || v[1] == NULL) fail("malloc failed");
+    for (i = 0; i < warmup; i++) {
+        b = chan_bit(i);
+        v[b][n[b]++] = m[i];
+    }
+    qsort(v[0], n[0], sizeof(uint64_t), by_value);
+    qsort(v[1], n[1], sizeof(uint64_t), by_value);
+    r->p50[0] = quantile(v[0], n[0], 0.50);
+    r->p50[1] = quantile(v[1], n[1], 0.50);
+    free(v[0]);
+    free(v[1]);
+
+    mid = (r->p50[0] + r->p50[1]) / 2;
+    up = (r->p50[1] > r->p50[0]);
+    r->bits = iters - warmup;
+    r->errors = 0;
+    for (i = warmup; i < iters; i++) {
+        if (((m[i] > mid) == up) != chan_bit(i)) r->errors++;
+    }
+    r->raw = 1e6 / r->slot_us;
+    r->capacity = r->raw * (1 - entropy((double)r->errors / r->bits));
+}
+
+/*
+ * One channel at one slot length: the sender at high, the receiver at low
+ */
+static int run_chan(int kind, uint64_t *samples[1], struct chan_result *r)
+{
+    const char *name = chan_names[kind];
+    int cpus[2] = { cpu_a, cpu_b };
+    char path[MAX_STRING];
+    pid_t tx, rx;
+    int status = 0;
+
+    // contention for a cpu needs the two sides on the same one
+    if (kind == CHAN_CPU && cpu_a >= 0 && cpu_b >= 0 && cpu_a != cpu_b) {
+        fprintf(stderr, "chan %s needs -a and -A on the same cpu\n", name);
+        return 0;
+    }
+    if (kind == CHAN_CACHE &&
+        chan_file_size() < (size_t)iters * FILE_BLOCK) {
+        fprintf(stderr, "chan %s needs -z of at least %d pages\n", name,
+                iters);
+        return 0;
+    }
+    fprintf(stderr, "chan %s %s to %s: %d slots of %d us\n", name,
+            lvl_high, lvl_low, iters, chan_slot_us);
+    snprintf(path, sizeof(path), CMP_SAMPLES, lvl_low);
+    if (cmp_key(CMP_KEY) != 0 || create_file(lvl_low, path, NULL) != 0 ||
+        (kind == CHAN_CACHE && create_file(lvl_low, CMP_FILE, NULL) != 0)) {
+        return 0;
+    }
+    if (kind == CHAN_CPU) {
+        if (cpu_a < 0) cpu_a = cpu_b < 0 ? 0 : cpu_b;
+        cpu_b = cpu_a;
+    }
+    status |= cmp_side(lvl_low, name, "chan-setup", NULL);
+    if (status == 0) {
+        chan_start_ns = now_ns() + CHAN_LEAD;
+        tx = cmp_spawn(lvl_high, name, "chan-send", NULL);
+        rx = cmp_spawn(lvl_low, name, "chan-recv", path);
+        status |= cmp_wait_pair(tx, rx);
+    }
+    status |= cmp_side(lvl_low, name, "chan-teardown", NULL);
+    cpu_a = cpus[0];
+    cpu_b = cpus[1];
+    unlink(CMP_KEY);
+    unlink(CMP_FILE);
+    if (status != 0 || read_samples(path, samples, 1) != 0) {
+        fprintf(stderr, "chan %s failed\n", name);
+        return 0;
+    }
+
+    r->name = name;
+    r->slot_us = chan_slot_us;
+    chan_decode(samples[0], r);
+    return 1;
+}
+
+static void print_chan(FILE *out, const char *format,
+                       const struct chan_result *res, int n)
+{
+    const struct chan_result *r, *best = NULL;
+    struct utsname u;
+    double ber;
+    int i;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "channel,sender,receiver,kernel,slot_us,bits,errors,"
+                     "ber,raw_bits_per_s,capacity_bits_per_s,p50_0,p50_1\n");
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "kernel %s, %s to %s, %d bits after a %d bit "
+                "preamble\n", u.release, lvl_high, lvl_low, iters - warmup,
+                warmup);
+        fprintf(out, "%-6s %8s %8s %10s %12s\n", "chan", "slot us",
+                "ber", "raw bit/s", "capacity b/s");
+    }
+    for (i = 0; i < n; i++) {
+        r = &res[i];
+        ber = (double)r->errors / r->bits;
+        if (strcmp(format, "csv") == 0) {
+            fprintf(out, "%s,%s,%s,%s,%d,%d,%d,%.4f,%.1f,%.1f,%.1f,%.1f\n",
+                    r->name, lvl_high, lvl_low, u.release, r->slot_us,
+                    r->bits, r->errors, ber, r->raw, r->capacity, r->p50[0],
+                    r->p50[1]);
+        } else if (strcmp(format, "json") == 0) {
+            fprintf(out, "  {\"channel\": \"%s\", \"sender\": \"%s\", "
+                    "\"receiver\": \"%s\", \"kernel\": \"%s\", "
+                    "\"slot_us\": %d, \"bits\": %d, \"errors\": %d, "
+                    "\"ber\": %.4f, \"raw_bits_per_s\": %.1f, "
+                    "\"capacity_bits_per_s\": %.1f, \"p50_0\": %.1f, "
+                    "\"p50_1\": %.1f}%s\n", r->name, lvl_high, lvl_low,
+                    u.release, r->slot_us, r->bits, r->errors, ber, r->raw,
+                    r->capacity, r->p50[0], r->p50[1], (i + 1 < n) ? "," : "");
+        } else {
+            fprintf(out, "%-6s %8d %8.4f %10.1f %12.1f\n", r->name,
+                    r->slot_us, ber, r->raw, r->capacity);
+        }
+        if (best == NULL || strcmp(best->name, r->name) != 0) best = r;
+        if (r->capacity > best->capacity) best = r;
+        // the best slot length of each channel closes its rows
+        if (strcmp(format, "text") == 0 &&
+            (i + 1 == n || strcmp(res[i + 1].name, r->name) != 0)) {
+            fprintf(out, "%-6s best %.1f bits/s at %d us\n", r->name,
+                    best->capacity, best->slot_us);
+        }
+    }
+    if (strcmp(format, "json") == 0) fprintf(out, "]\n");
+}
+
+/*
+ * Every channel (or just -b kind) at each slot length, or the one -t
+ */
+static int chan_capacity(FILE *out, const char *format, const char *only)
+{
+    struct chan_result res[CHAN_KINDS * sizeof(chan_slots) /
+                           sizeof(chan_slots[0])];
+    uint64_t *samples[1];
+    int slot = chan_slot_us;
+    int n = 0;
+    int k, i;
+
+    if (warmup < 2 || warmup >= iters) {
+        fprintf(stderr, "the preamble (-w) needs 2 to %d slots\n",
+                iters - 1);
+        return -1;
+    }
+    alloc_samples(samples, 1);
+    for (k = 0; k < CHAN_KINDS; k++) {
+        if (only != NULL && strcmp(only, chan_names[k]) != 0) continue;
+        for (i = 0; slot ? i == 0 : chan_slots[i] != 0; i++) {
+            chan_slot_us = slot ? slot : chan_slots[i];
+            n += run_chan(k, samples, &res[n]);
+        }
+    }
+    free_samples(samples, 1);
+    if (n == 0) return -1;
+    print_chan(out, format, res, n);
+    return 0;
+}
+
+
+/*****************************************************************************
+ * Storage channel scan (-E). Opening an object above the caller's level
+ * fails with EACCES, and opening one that does not exist with ENOENT, so
+ * a low process learns which high names exist. For each namespace the
+ * helpers use, a high sender makes a batch of SCAN_BATCH names exist for
+ * the 1 bits of a message and not for the 0 bits; a low receiver probes
+ * every name of the batch and reads a 1 for anything but ENOENT:
+ *
+ *   shm    POSIX shm names, /mls_scan_<n>
+ *   shm_v  System V segments     } keys counting up from the ftok() key
+ *   msg    System V queues       } of the bench's anchor file
+ *   sem    System V sets         }
+ *   fifo   FIFOs, files/scan.<n>.fifo
+ *   file   files, files/scan.<n>
+ *
+ * A high process may not add a name to the low files/ directory, so the
+ * FIFOs and files are made by the runner at the high level, as the test
+ * fixtures are; their rate is what a low process learns about high
+ * fixtures. Every batch has its own names, so the steps need not meet
+ * between batches: the sender encodes all -n batches (after -w more),
+ * the receiver then probes them all, and the sender clears them all at
+ * the end, timing each batch of each step. Up to (n + w) * SCAN_BATCH / 2
+ * names exist at once. The report gives the errno of every probe against
+ * the bit sent, the bit error rate, the probe rate and the capacity of a
+ * batch's encode, probe and clear together.
+ */
+
+#define SCAN_BATCH  64
+#define SCAN_ROUNDS 20          // default -n
+#define SCAN_WARMUP 2           // default -w
+#define SCAN_SHM    "/mls_scan_%d"
+#define SCAN_FIFO   "files/scan.%d.fifo"
+#define SCAN_FILE   "files/scan.%d"
+
+enum scan_kind { SCAN_SHM_P, SCAN_SHM_V, SCAN_MSG, SCAN_SEM, SCAN_FIFO_P,
+                 SCAN_FILE_P, SCAN_KINDS };
+enum scan_out { OUT_OK, OUT_EACCES, OUT_ENOENT, OUT_OTHER, OUT_KINDS };
+
+static const char *scan_names[SCAN_KINDS] = {
+    "shm", "shm_v", "msg", "sem", "fifo", "file"
+};
+
+/* The receiver's samples: the probe time, then counts[bit][outcome] */
+#define SCAN_TIME       0
+#define SCAN_COUNT(b, o)    (1 + (b) * OUT_KINDS + (o))
+#define SCAN_ARRAYS     (1 + 2 * OUT_KINDS)
+
+struct scan_result {
+    const char *name;
+    unsigned long count[2][OUT_KINDS];  // probes, by bit sent and outcome
+    unsigned long errors;
+    double ber;
+    struct stats encode, probe, clear;  // ns a batch
+    struct stats round;                 // ns to encode, probe and clear
+    double probe_rate, capacity;        // bits/s
+};
+
+
+/*
+ * Name n of a round; every round has its own names, warmup included
+ */
+static int scan_index(int round, int i)
+{
+    return (round + warmup) * SCAN_BATCH + i;
+}
+
+static int scan_bit(int round, int i)
+{
+    return message_bit(scan_index(round, i));
+}
+
+static key_t scan_key(int n)
+{
+    key_t key = ftok(CMP_KEY, TEST_KEY_ID);
+
+    if (key == (key_t)-1) fail("ftok failed");
+    return key + 1 + n;
+}
+
+static const char *scan_path(int kind, int n, char *buf, size_t len)
+{
+    const char *fmt = (kind == SCAN_SHM_P) ? SCAN_SHM :
+                      (kind == SCAN_FIFO_P) ? SCAN_FIFO : SCAN_FILE;
+
+    snprintf(buf, len, fmt, n);
+    return buf;
+}
+
+/*
+ * Make name n exist at the caller's level. FIFOs and files take the
+ * create context scan_encode() set; unlike create_fifo() and
+ * create_file() they log nothing, as they are inside the timed batch.
+ */
+static int scan_create(int kind, int n)
+{
+    char path[MAX_STRING];
+    int fd;
+
+    switch (kind) {
+        case SCAN_SHM_P:
+            fd = shm_open(scan_path(kind, n, path, sizeof(path)),
+                          O_CREAT | O_EXCL | O_RDWR, MODE_RWX);
+            if (fd >= 0) close(fd);
+            return fd;
+        case SCAN_SHM_V:
+            return shmget(scan_key(n), FILE_BLOCK,
+                          IPC_CREAT | IPC_EXCL | MODE_RWX);
+        case SCAN_MSG:
+            return msgget(scan_key(n), IPC_CREAT | IPC_EXCL | MODE_RWX);
+        case SCAN_SEM:
+            return semget(scan_key(n), 1, IPC_CREAT | IPC_EXCL | MODE_RWX);
+        case SCAN_FIFO_P:
+            return mkfifo(scan_path(kind, n, path, sizeof(path)),
+                          MODE_RWX);
+        case SCAN_FILE_P:
+            fd = open(scan_path(kind, n, path, sizeof(path)),
+                      O_CREAT | O_EXCL | O_WRONLY, MODE_RWX);
+            if (fd >= 0) close(fd);
+            return fd;
+    }
+    return -1;
+}
+
+static void scan_remove(int kind, int n)
+{
+    char path[MAX_STRING];
+    int id;
+
+    switch (kind) {
+        case SCAN_SHM_P:
+            shm_unlink(scan_path(kind, n, path, sizeof(path)));
+            break;
+        case SCAN_SHM_V:
+            if ((id = shmget(scan_key(n), 0, 0)) >= 0) {
+                shmctl(id, IPC_RMID, NULL);
+            }
+            break;
+        case SCAN_MSG:
+            if ((id = msgget(scan_key(n), 0)) >= 0) {
+                msgctl(id, IPC_RMID, NULL);
+            }
+            break;
+        case SCAN_SEM:
+            if ((id = semget(scan_key(n), 0, 0)) >= 0) {
+                semctl(id, 0, IPC_RMID);
+            }
+            break;
+        default:
+            unlink(scan_path(kind, n, path, sizeof(path)));
+    }
+}
+
+/*
+ * Open name n to read, as the helpers attach; the outcome is all we keep
+ */
+static int scan_probe(int kind, int n)
+{
+    char path[MAX_STRING];
+    int fd = -1;
+
+    switch (kind) {
+        case SCAN_SHM_P:
+            fd = shm_open(scan_path(kind, n, path, sizeof(path)), O_RDONLY,
+                          0);
+            break;
+        case SCAN_SHM_V:
+            if (shmget(scan_key(n), 0, MODE_R) >= 0) return OUT_OK;
+            break;
+        case SCAN_MSG:
+            if (msgget(scan_key(n), MODE_R) >= 0) return OUT_OK;
+            break;
+        case SCAN_SEM:
+            if (semget(scan_key(n), 0, MODE_R) >= 0) return OUT_OK;
+            break;
+        case SCAN_FIFO_P:
+            fd = open(scan_path(kind, n, path, sizeof(path)),
+                      O_RDONLY | O_NONBLOCK);
+            break;
+        case SCAN_FILE_P:
+            fd = open(scan_path(kind, n, path, sizeof(path)), O_RDONLY);
+            break;
+    }
+    if (fd >= 0) {
+        close(fd);
+        return OUT_OK;
+    }
+    return (errno == EACCES) ? OUT_EACCES :
+           (errno == ENOENT) ? OUT_ENOENT : OUT_OTHER;
+}
+
+/*
+ * The sender: each round's 1 names made to exist, or removed again
+ */
+static int scan_encode(int kind, uint64_t *samples[1])
+{
+    const struct level_context *c;
+    uint64_t start;
+    int r, i;
+
+    // the runner makes FIFOs and files at the high level
+    if (kind == SCAN_FIFO_P || kind == SCAN_FILE_P) {
+        if ((c = level_context(lvl_high)) == NULL ||
+            setfscreatecon(c->file) != 0) {
+            perror("setfscreatecon failed");
+            return -1;
+        }
+    }
+    for (r = -warmup; r < iters; r++) {
+        start = now_ns();
+        for (i = 0; i < SCAN_BATCH; i++) {
+            if (scan_bit(r, i) && scan_create(kind, scan_index(r, i)) < 0) {
+                perror("create failed");
+                return -1;
+            }
+        }
+        if (r >= 0) samples[0][r] = now_ns() - start;
+    }
+    return 0;
+}
+
+static void scan_clear(int kind, uint64_t *samples[1])
+{
+    uint64_t start;
+    int r, i;
+
+    for (r = -warmup; r < iters; r++) {
+        start = now_ns();
+        for (i = 0; i < SCAN_BATCH; i++) {
+            if (scan_bit(r, i)) scan_remove(kind, scan_index(r, i));
+        }
+        if (r >= 0) samples[0][r] = now_ns() - start;
+    }
+}
+
+static void scan_receive(int kind, uint64_t *samples[SCAN_ARRAYS])
+{
+    unsigned char out[SCAN_BATCH];
+    uint64_t start;
+    int r, i, k;
+
+    for (r = -warmup; r < iters; r++) {
+        start = now_ns();
+        for (i = 0; i < SCAN_BATCH; i++) {
+            out[i] = scan_probe(kind, scan_index(r, i));
+        }
+        if (r < 0) continue;
+        samples[SCAN_TIME][r] = now_ns() - start;
+        // tallied off the clock, against the bits that were sent
+        for (k = 1; k < SCAN_ARRAYS; k++) samples[k][r] = 0;
+        for (i = 0; i < SCAN_BATCH; i++) {
+            samples[SCAN_COUNT(scan_bit(r, i), out[i])][r]++;
+        }
+    }
+}
+
+/*
+ * A side of the scan (-X scan-encode|scan-probe|scan-clear -b kind)
+ */
+static int scan_side_main(const char *side, const char *name,
+                          const char *path)
+{
+    uint64_t *samples[SCAN_ARRAYS];
+    int kind = find_name(scan_names, SCAN_KINDS, name);
+
+    if (kind < 0) return -1;
+    alloc_samples(samples, SCAN_ARRAYS);
+    if (strcmp(side, "encode") == 0) {
+        if (scan_encode(kind, samples) != 0) return -1;
+        write_samples(path, samples, 1);
+    } else if (strcmp(side, "clear") == 0) {
+        scan_clear(kind, samples);
+        write_samples(path, samples, 1);
+    } else if (strcmp(side, "probe") == 0) {
+        pin(cpu_a);
+        scan_receive(kind, samples);
+        write_samples(path, samples, SCAN_ARRAYS);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * Encode or clear at the high level: in a side for IPC objects, here for
+ * FIFOs and files
+ */
+static int scan_sender(int kind, const char *side, uint64_t *samples[1])
+{
+    char path[MAX_STRING];
+    int status = 0;
+
+    if (kind == SCAN_FIFO_P || kind == SCAN_FILE_P) {
+        if (strcmp(side, "scan-encode") == 0) {
+            return scan_encode(kind, samples);
+        }
+        scan_clear(kind, samples);
+        return 0;
+    }
+    snprintf(path, sizeof(path), CMP_SAMPLES, lvl_high);
+    if (create_file(lvl_high, path, NULL) != 0 ||
+        cmp_side(lvl_high, scan_names[kind], side, path) != 0 ||
+        read_samples(path, samples, 1) != 0) {
+        status = -1;
+    }
+    return status;
+}
+
+static int run_scan(int kind, struct scan_result *r)
+{
+    const char *name = scan_names[kind];
+    uint64_t *samples[SCAN_ARRAYS], *enc[1], *clr[1], *total[1];
+    char path[MAX_STRING];
+    unsigned long probes;
+    int status = 0;
+    int i, b, o;
+
+    memset(r, 0, sizeof(*r));
+    fprintf(stderr, "scan %s %s from %s: %d batches of %d\n", name,
+            lvl_high, lvl_low, iters, SCAN_BATCH);
+    snprintf(path, sizeof(path), CMP_SAMPLES, lvl_low);
+    if (cmp_key(CMP_KEY) != 0 || create_file(lvl_low, path, NULL) != 0) {
+        return 0;
+    }
+    alloc_samples(samples, SCAN_ARRAYS);
+    alloc_samples(enc, 1);
+    alloc_samples(clr, 1);
+    alloc_samples(total, 1);
+    status |= scan_sender(kind, "scan-encode", enc);
+    if (status == 0) {
+        status |= cmp_side(lvl_low, name, "scan-probe", path);
+        if (status == 0) status |= read_samples(path, samples, SCAN_ARRAYS);
+    }
+    // clear even after a failure, so no names are left behind
+    status |= scan_sender(kind, "scan-clear", clr);
+    unlink(CMP_KEY);
+
+    if (status == 0) {
+        r->name = name;
+        for (i = 0; i < iters; i++) {
+            for (b = 0; b < 2; b++) {
+                for (o = 0; o < OUT_KINDS; o++) {
+                    r->count[b][o] += samples[SCAN_COUNT(b, o)][i];
+                }
+            }
+            total[0][i] = enc[0][i] + samples[SCAN_TIME][i] + clr[0][i];
+        }
+        // a 1 reads as anything but ENOENT
+        r->errors = r->count[1][OUT_ENOENT] + r->count[0][OUT_OK] +
+                    r->count[0][OUT_EACCES] + r->count[0][OUT_OTHER];
+        probes = (unsigned long)iters * SCAN_BATCH;
+        r->ber = (double)r->errors / probes;
+        summarize(enc[0], iters, &r->encode);
+        summarize(samples[SCAN_TIME], iters, &r->probe);
+        summarize(clr[0], iters, &r->clear);
+        summarize(total[0], iters, &r->round);
+        r->probe_rate = SCAN_BATCH / r->probe.p50 * 1e9;
+        r->capacity = SCAN_BATCH / r->round.p50 * 1e9 *
+                      (1 - entropy(r->ber));
+    } else {
+        fprintf(stderr, "scan %s failed\n", name);
+    }
+    free_samples(samples, SCAN_ARRAYS);
+    free_samples(enc, 1);
+    free_samples(clr, 1);
+    free_samples(total, 1);
+    return status == 0;
+}
+
+
+static void print_scan(FILE *out, const char *format,
+                       const struct scan_result *res, int n)
+{
+    static const char *outs[OUT_KINDS] = { "ok", "eacces", "enoent",
+                                           "other" };
+    const struct scan_result *r;
+    struct utsname u;
+    int i, b, o;
+
+    uname(&u);
+    if (strcmp(format, "csv") == 0) {
+        fprintf(out, "class,sender,receiver,kernel,probes");
+        for (b = 1; b >= 0; b--) {
+            for (o = 0; o < OUT_KINDS; o++) {
+                fprintf(out, ",sent%d_%s", b, outs[o]);
+            }
+        }
+        fprintf(out, ",ber,encode_ns,probe_ns,clear_ns,probe_bits_per_s,"
+                     "capacity_bits_per_s\n");
+    } else if (strcmp(format, "json") == 0) {
+        fprintf(out, "[\n");
+    } else {
+        fprintf(out, "kernel %s, %s to %s, %d batches of %d names after "
+                "%d\n", u.release, lvl_high, lvl_low, iters, SCAN_BATCH,
+                warmup);
+        fprintf(out, "%-5s  %-23s  %s\n", "", "sent 1", "sent 0");
+        fprintf(out, "%-5s  %5s %5s %5s %5s  %5s %5s %5s %5s %7s %9s %9s  "
+                "(p50)\n", "class", "ok", "eacc", "noent", "other", "ok",
+                "eacc", "noent", "other", "ber", "probe b/s", "capacity");
+    }
+    for (i = 0; i < n; i++) {
+        r = &res[i];
+        if (strcmp(format, "csv") == 0) {
+            fprintf(out, "%s,%s,%s,%s,%lu", r->name, lvl_high, lvl_low,
+                    u.release, (unsigned long)iters * SCAN_BATCH);
+            for (b = 1; b >= 0; b--) {
+                for (o = 0; o < OUT_KINDS; o++) {
+                    fprintf(out, ",%lu", r->count[b][o]);
+                }
+            }
+            fprintf(out, ",%.4f,%.0f,%.0f,%.0f,%.0f,%.0f\n", r->ber,
+                    r->encode.p50, r->probe.p50, r->clear.p50,
+                    r->probe_rate, r->capacity);
+        } else if (strcmp(format, "json") == 0) {
+            fprintf(out, "  {\"class\": \"%s\", \"sender\": \"%s\", "
+                    "\"receiver\": \"%s\", \"kernel\": \"%s\", "
+                    "\"probes\": %lu", r->name, lvl_high, lvl_low,
+                    u.release, (unsigned long)iters * SCAN_BATCH);
+            for (b = 1; b >= 0; b--) {
+                for (o = 0; o < OUT_KINDS; o++) {
+                    fprintf(out, ", \"sent%d_%s\": %lu", b, outs[o],
+                            r->count[b][o]);
+                }
+            }
+            fprintf(out, ", \"ber\": %.4f, \"encode_ns\": %.0f, "
+                    "\"probe_ns\": %.0f, \"clear_ns\": %.0f, "
+                    "\"probe_bits_per_s\": %.0f, "
+                    "\"capacity_bits_per_s\": %.0f}%s\n", r->ber,
+                    r->encode.p50, r->probe.p50, r->clear.p50,
+                    r->probe_rate, r->capacity, (i + 1 < n) ? "," : "");
+        } else {
+            fprintf(out, "%-5s  %5lu %5lu %5lu %5lu  %5lu %5lu %5lu %5lu "
+                    "%7.4f %9.0f %9.0f\n", r->name, r->count[1][OUT_OK],
+                    r->count[1][OUT_EACCES], r->count[1][OUT_ENOENT],
+                    r->count[1][OUT_OTHER], r->count[0][OUT_OK],
+                    r->count[0][OUT_EACCES], r->count[0][OUT_ENOENT],
+                    r->count[0][OUT_OTHER], r->ber, r->probe_rate,
+                    r->capacity);
+        }
+    }
+    if (strcmp(format, "json") == 0) fprintf(out, "]\n");
+}
+
+/*
+ * Every class, or just -b class
+ */
+static int scan_storage(FILE *out, const char *format, const char *only)
+{
+    struct scan_result res[SCAN_KINDS];
+    int n = 0;
+    int k;
+
+    for (k = 0; k < SCAN_KINDS; k++) {
+        if (only != NULL && strcmp(only, scan_names[k]) != 0) continue;
+        n += run_scan(k, &res[n]);
+    }
+    if (n == 0) return -1;
+    print_scan(out, format, res, n);
+    return 0;
+}
+
+
+static void usage(const char *prog)
+{
+    const struct bench *b;
+    const struct cmp_bench *c;
+
+    fprintf(stderr, "usage: %s [-c] [-b bench] [-n iters] [-w warmup] "
+                    "[-a cpu] [-A cpu]\n"
+                    "       [-S [-s bytes]] [-m [-z size] [-x opts]] "
+                    "[-P [-x opts]]\n"
+                    "       [-F [-z size]] [-R [-b path] [-z size]] "
+                    "[-C [-b chan] [-t us]]\n"
+                    "       [-E [-b class]] [-L low] [-H high] "
+                    "[-o text|csv|json] [-f file]\n", prog);
+    fprintf(stderr, "  -b bench  run one benchmark:");
+    for (b = benches; b->name != NULL; b++) fprintf(stderr, " %s", b->name);
+    fprintf(stderr, "\n            or with -c:");
+    for (c = cmp_benches; c->name != NULL; c++) {
+        fprintf(stderr, " %s", c->name);
+    }
+    fprintf(stderr, "\n  -c        compare the runner's context, the same "
+                    "level and read-down\n");
+    fprintf(stderr, "  -S        stream messages from low to high, sweeping "
+                    "the size\n");
+    fprintf(stderr, "  -s bytes  stream just this message size\n");
+    fprintf(stderr, "  -m        read shared memory at low and high, "
+                    "sweeping the size\n");
+    fprintf(stderr, "  -z size   use just this size (K, M, G): the -m "
+                    "segment, the -F pass,\n"
+                    "            the -R file or the -C cache file\n");
+    fprintf(stderr, "  -P        semaphore ping-pong, and a signal from low "
+                    "to high\n");
+    fprintf(stderr, "  -F        stream through a FIFO from low to low and "
+                    "high, -z a pass\n");
+    fprintf(stderr, "  -R        read a low file at low and high: read, "
+                    "mmap, direct, uring, open\n");
+    fprintf(stderr, "  -C        covert timing channels from high to low: "
+                    "cpu, cache, sem, msg\n");
+    fprintf(stderr, "  -t us     use just this bit slot for -C\n");
+    fprintf(stderr, "  -E        scan for EACCES/ENOENT storage channels: "
+                    "shm, shm_v, msg, sem,\n"
+                    "            fifo, file\n");
+    fprintf(stderr, "  -x opts   for -m: huge,populate,lock; for -P: "
+                    "undo,timed\n");
+    fprintf(stderr, "  -a cpu    pin side A (the timed side) to cpu\n");
+    fprintf(stderr, "  -A cpu    pin side B to cpu\n");
+    fprintf(stderr, "  -L, -H    the low and high levels for -c (default "
+                    "%s, %s)\n", LVL_LOW, LVL_HIGH);
+    fprintf(stderr, "  -f file   write the results to file, not stdout\n");
+    exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+    struct bench_result res[sizeof(benches) / sizeof(benches[0])];
+    struct cmp_result cres[2 * sizeof(cmp_benches) / sizeof(cmp_benches[0])];
+    const struct bench *b;
+    const struct cmp_bench *c;
+    const char *only = NULL;
+    const char *format = "text";
+    const char *path = NULL;
+    const char *samples = NULL;
+    const char *side = NULL;
+    const char *size_arg = NULL;
+    const char *opts_arg = NULL;
+    const struct mode_args *mode;
+    int compare = 0;
+    int stream = 0;
+    int bandwidth = 0;
+    int latency = 0;
+    int fifo = 0;
+    int file = 0;
+    int covert = 0;
+    int scan = 0;
+    FILE *out;
+    int n = 0;
+    int opt;
+
+    self = argv[0];
+    while ((opt = getopt(argc, argv,
+                         "a:A:b:cCEf:FH:L:mn:No:p:PRs:St:T:w:x:X:z:")) != -1) {
+        switch (opt) {
+            case 'a':
+                cpu_a = atoi(optarg);
+                break;
+            case 'A':
+                cpu_b = atoi(optarg);
+                break;
+            case 'b':
+                only = optarg;
+                break;
+            case 'c':
+                compare = 1;
+                break;
+            case 'C':
+                covert = 1;
+                break;
+            case 'E':
+                scan = 1;
+                break;
+            case 'F':
+                fifo = 1;
+                break;
+            case 'H':
+                lvl_high = optarg;
+                break;
+            case 'L':
+                lvl_low = optarg;
+                break;
+            case 'm':
+                bandwidth = 1;
+                break;
+            case 'N':
+                stream_nowait = 1;
+                break;
+            case 'P':
+                latency = 1;
+                break;
+            case 'R':
+                file = 1;
+                break;
+            case 's':
+                stream_size = atoi(optarg);
+                break;
+            case 'S':
+                stream = 1;
+                break;
+            case 't':
+                chan_slot_us = atoi(optarg);
+                break;
+            case 'T':
+                chan_start_ns = strtoull(optarg, NULL, 10);
+                break;
+            case 'x':
+                opts_arg = optarg;
+                break;
+            case 'X':
+                side = optarg;
+                break;
+            case 'z':
+                size_arg = optarg;
+                break;
+            case 'f':
+                path = optarg;
+                break;
+            case 'p':
+                samples = optarg;
+                break;
+            case 'n':
+                iters = atoi(optarg);
+                break;
+            case 'o':
+                format = optarg;
+                break;
+            case 'w':
+                warmup = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (iters < 0) iters = covert ? CHAN_BITS : scan ? SCAN_ROUNDS :
+                           (bandwidth || fifo || file) ? BW_CYCLES : 10000;
+    if (warmup < 0) warmup = covert ? CHAN_SYNC : scan ? SCAN_WARMUP :
+                             (bandwidth || fifo || file) ? 1 : 1000;
+    if (iters == 0) usage(argv[0]);
+    // -z and -x are for the mode that was picked, or for the side's
+    mode = find_mode(side ? side : bandwidth ? "bw-" : latency ? "sem-" :
+                     fifo ? "fifo-" : file ? "file-" : covert ? "chan-" :
+                     NULL);
+    if (side == NULL &&
+        ((size_arg != NULL && (mode == NULL || mode->size == NULL)) ||
+         (opts_arg != NULL && (mode == NULL || mode->opts == NULL)))) {
+        fprintf(stderr, "-z is for -m, -F, -R and -C; -x for -m and -P\n");
+        return -1;
+    }
+    if (size_arg != NULL && mode != NULL && mode->size != NULL) {
+        *mode->size = parse_size(size_arg);
+    }
+    if (opts_arg != NULL && mode != NULL && mode->opts != NULL) {
+        *mode->opts = opts_arg;
+    }
+    if (!usable(cpu_a) || !usable(cpu_b)) {
+        fprintf(stderr, "cpu %d is not available\n",
+                usable(cpu_a) ? cpu_b : cpu_a);
+        return -1;
+    }
+    if (side != NULL) {
+        if (only == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+            return -1;
+        }
+        if (!strcmp(side, "produce") || !strcmp(side, "consume")) {
+            return stream_side_main(side, samples);
+        }
+        if (strncmp(side, "bw-", 3) == 0) {
+            return bw_side_main(side + 3, only, samples);
+        }
+        if (strncmp(side, "sem-", 4) == 0) {
+            return sem_side_main(side + 4, samples);
+        }
+        if (strncmp(side, "fifo-", 5) == 0) {
+            return fifo_side_main(side + 5, only, samples);
+        }
+        if (strncmp(side, "file-", 5) == 0) {
+            return file_side_main(side + 5, only, samples);
+        }
+        if (strncmp(side, "chan-", 5) == 0) {
+            return chan_side_main(side + 5, only, samples);
+        }
+        if (strncmp(side, "scan-", 5) == 0) {
+            return scan_side_main(side + 5, only, samples);
+        }
+        return cmp_side_main(side, only, samples);
+    }
+
+    // results go to the real stdout; the primitives' logging does not
+    out = path ? fopen(path, "w") : fdopen(dup(STDOUT_FILENO), "w");
+    if (out == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        perror("opening output failed");
+        return -1;
+    }
+
+    if (scan) {
+        n = scan_storage(out, format, only);
+        fclose(out);
+        return n;
+    }
+    if (covert) {
+        n = chan_capacity(out, format, only);
+        fclose(out);
+        return n;
+    }
+    if (file) {
+        n = file_throughput(out, format, only);
+        fclose(out);
+        return n;
+    }
+    if (fifo) {
+        n = fifo_throughput(out, format);
+        fclose(out);
+        return n;
+    }
+    if (latency) {
+        n = sem_latency(out, format);
+        fclose(out);
+        return n;
+    }
+    if (bandwidth) {
+        n = bw_sweep(out, format);
+        fclose(out);
+        return n;
+    }
+    if (stream) {
+        n = stream_sweep(out, format);
+        fclose(out);
+        return n;
+    }
+    if (compare) {
+        for (c = cmp_benches; c->name != NULL; c++) {
+            if (only != NULL && strcmp(only, c->name) != 0) continue;
+            n += run_compare(c, &cres[n]);
+        }
+        if (n == 0) usage(argv[0]);
+        print_compare(out, format, cres, n);
+        fclose(out);
+        return 0;
+    }
+
+    for (b = benches; b->name != NULL; b++) {
+        if (only != NULL && strcmp(only, b->name) != 0) continue;
+        fprintf(stderr, "%s: %d iterations\n", b->name, warmup + iters);
+        if (run_bench(b, &res[n]) == 0) n++;
+    }
+    if (n == 0) usage(argv[0]);
+
+    print_results(out, format, res, n);
+    fclose(out);
+    return 0;
+}
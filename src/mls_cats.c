@@ -0,0 +1,280 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Category (MCS compartment) cases. A case is a subject label and an
+ * object label, described by four factors: how the sensitivities compare,
+ * how the category sets relate (equal, subset, superset, disjoint,
+ * overlapping), how many categories the object has, and where in
+ * c0.c1023 they sit. Running every combination is 135 cases per class;
+ * instead a greedy pairwise sampler picks cases until every pair of
+ * factor values has been seen at least once, which takes 15. Cells are
+ * grouped by category count, so the matrix report shows how label size
+ * changes the time per cell.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mls_cats.h"
+#include "mls_matrix.h"
+
+enum { F_SENS, F_REL, F_SIZE, F_POS, NFACTORS };
+
+static const char *sens_names[] = { "lower", "equal", "higher" };
+static const char *rel_names[] = {
+    "equal", "subset", "superset", "disjoint", "overlap"
+};
+static const char *size_names[] = { "1 cat", "16 cats", "512 cats" };
+static const char *pos_names[] = { "bottom", "top", "spread" };
+
+static const int nvalues[NFACTORS] = { 3, 5, 3, 3 };
+static const int sizes[] = { 1, 16, 512 };
+
+#define CATS_BASE_SENS 5
+#define CATS_RUNS      4        // a spread set is this many runs
+
+struct cats_case {
+    int f[NFACTORS];
+    char name[2][8];            // k<N>s, k<N>o
+    char lvl[2][MAX_STRING];    // subject and object labels
+};
+
+static struct cats_case cases[MATRIX_MAX_CELLS / 2];
+static int ncases = 0;
+
+
+/*
+ * Render a category map as c<a>.c<b>,c<x>,... after s<sens>
+ */
+static void cats_format(char *buf, size_t len, int sens,
+                        const unsigned char *cats)
+{
+    size_t n;
+    int a, b;
+    char sep = ':';
+
+    n = snprintf(buf, len, "s%d", sens);
+    for (a = 0; a < MLS_CATS && n < len; a = b + 1) {
+        if (!cats[a]) {
+            b = a;
+            continue;
+        }
+        for (b = a; b + 1 < MLS_CATS && cats[b + 1]; b++)
+            ;
+        if (b == a) {
+            n += snprintf(buf + n, len - n, "%cc%d", sep, a);
+        } else {
+            n += snprintf(buf + n, len - n, "%cc%d.c%d", sep, a, b);
+        }
+        sep = ',';
+    }
+}
+
+/*
+ * The object's categories: size of them at the bottom or top of c0.c1023,
+ * or spread over it in a few runs
+ */
+static void cats_place(unsigned char *cats, int size, int pos)
+{
+    int runs, per, gap, r, i, start;
+
+    memset(cats, 0, MLS_CATS);
+    if (pos == 2 && size >= CATS_RUNS) {
+        runs = CATS_RUNS;
+    } else {
+        runs = 1;
+    }
+    per = size / runs;
+    gap = MLS_CATS / runs;
+    for (r = 0; r < runs; r++) {
+        if (pos == 1) {
+            start = MLS_CATS - size;
+        } else if (pos == 2) {
+            start = r * gap + (gap - per) / 2;
+        } else {
+            start = 0;
+        }
+        for (i = 0; i < per; i++) {
+            cats[start + i] = 1;
+        }
+    }
+}
+
+/*
+ * A category outside the set, searching from the middle of c0.c1023
+ */
+static int cats_outside(const unsigned char *cats, int skip)
+{
+    int i, c;
+
+    for (i = 0; i < MLS_CATS; i++) {
+        c = (MLS_CATS / 2 + i) % MLS_CATS;
+        if (!cats[c] && c != skip) return c;
+    }
+    return -1;
+}
+
+/*
+ * Turn a case's factors into a subject and an object label
+ */
+static void cats_build(struct cats_case *k)
+{
+    unsigned char obj[MLS_CATS], subj[MLS_CATS];
+    int size = sizes[k->f[F_SIZE]];
+    int i, n, x, y;
+
+    cats_place(obj, size, k->f[F_POS]);
+    memcpy(subj, obj, MLS_CATS);
+
+    switch (k->f[F_REL]) {
+        case 1:     // subject has the first half (none, for one category)
+            for (i = 0, n = 0; i < MLS_CATS; i++) {
+                if (obj[i] && n++ >= size / 2) subj[i] = 0;
+            }
+            break;
+        case 2:     // subject has one more
+            subj[cats_outside(obj, -1)] = 1;
+            break;
+        case 3:     // subject has as many, none in common
+            memset(subj, 0, MLS_CATS);
+            for (i = 0, n = 0; n < size; i++) {
+                if (!obj[i]) {
+                    subj[i] = 1;
+                    n++;
+                }
+            }
+            break;
+        case 4:     // both have the set and one the other lacks
+            x = cats_outside(obj, -1);
+            y = cats_outside(obj, x);
+            subj[x] = 1;
+            obj[y] = 1;
+            break;
+    }
+
+    cats_format(k->lvl[0], sizeof(k->lvl[0]),
+                CATS_BASE_SENS + k->f[F_SENS] - 1, subj);
+    cats_format(k->lvl[1], sizeof(k->lvl[1]), CATS_BASE_SENS, obj);
+}
+
+
+#define MAX_VALUES 5
+typedef unsigned char coverage_t[NFACTORS][NFACTORS][MAX_VALUES][MAX_VALUES];
+
+/*
+ * Number of factor-value pairs a case would cover that are not yet covered
+ */
+static int cats_gain(const int *f, coverage_t covered)
+{
+    int a, b, gain = 0;
+
+    for (a = 0; a < NFACTORS; a++) {
+        for (b = a + 1; b < NFACTORS; b++) {
+            if (!covered[a][b][f[a]][f[b]]) gain++;
+        }
+    }
+    return gain;
+}
+
+static void cats_cover(const int *f, coverage_t covered)
+{
+    int a, b;
+
+    for (a = 0; a < NFACTORS; a++) {
+        for (b = a + 1; b < NFACTORS; b++) {
+            covered[a][b][f[a]][f[b]] = 1;
+        }
+    }
+}
+
+/*
+ * Step f to the next combination of factor values
+ *
+ * Returns 0 after the last one
+ */
+static int cats_next(int *f)
+{
+    int i;
+
+    for (i = NFACTORS - 1; i >= 0; i--) {
+        if (++f[i] < nvalues[i]) return 1;
+        f[i] = 0;
+    }
+    return 0;
+}
+
+
+/*
+ * Choose the cases and put their labels and pairs in the matrix. Must be
+ * called before any suite is generated.
+ *
+ * Returns the number of cases, or -1
+ */
+int cats_generate(void)
+{
+    static coverage_t covered;
+    int f[NFACTORS], best[NFACTORS];
+    int gain, best_gain;
+    struct cats_case *k;
+    int i, s, o;
+
+    memset(covered, 0, sizeof(covered));
+    for (;;) {
+        // greedy: the combination covering most uncovered pairs
+        memset(f, 0, sizeof(f));
+        best_gain = 0;
+        do {
+            gain = cats_gain(f, covered);
+            if (gain > best_gain) {
+                best_gain = gain;
+                memcpy(best, f, sizeof(f));
+            }
+        } while (cats_next(f));
+        if (best_gain == 0) break;
+        if (ncases == MATRIX_MAX_CELLS / 2) return -1;
+
+        k = &cases[ncases];
+        memcpy(k->f, best, sizeof(best));
+        cats_cover(best, covered);
+        cats_build(k);
+        snprintf(k->name[0], sizeof(k->name[0]), "k%ds", ncases);
+        snprintf(k->name[1], sizeof(k->name[1]), "k%do", ncases);
+        ncases++;
+    }
+
+    for (i = 0; i < MATRIX_MAX_GROUPS && i < nvalues[F_SIZE]; i++) {
+        matrix_groups[i] = size_names[i];
+    }
+    for (i = 0; i < ncases; i++) {
+        k = &cases[i];
+        s = matrix_add_level(k->name[0], k->lvl[0], k->name[0]);
+        o = matrix_add_level(k->name[1], k->lvl[1], k->name[1]);
+        if (s < 0 || o < 0 || matrix_add_pair(s, o, k->f[F_SIZE]) != 0) {
+            return -1;
+        }
+    }
+    return ncases;
+}
+
+
+/*
+ * List the cases, so failing test names can be traced to their labels
+ */
+void cats_report(void)
+{
+    const struct cats_case *k;
+    int i;
+
+    for (i = 0; i < ncases; i++) {
+        k = &cases[i];
+        fprintf(stderr, "k%-3d %-7s %-8s %-8s %-6s  %s vs %s\n", i,
+                sens_names[k->f[F_SENS]], rel_names[k->f[F_REL]],
+                size_names[k->f[F_SIZE]], pos_names[k->f[F_POS]],
+                k->lvl[0], k->lvl[1]);
+    }
+}
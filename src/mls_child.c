@@ -0,0 +1,384 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Launching helpers at a level without waiting for them. Each child is
+ * tracked through a pidfd, so one epoll loop in the runner can watch any
+ * number of helpers and reap each one, with its rusage, as it exits.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/epoll.h>
+#include <sys/syscall.h>
+#include <selinux/selinux.h>
+#include <CUnit/CUnit.h>
+#include "mls_child.h"
+#include "mls_report.h"
+#include "mls_phase.h"
+
+#ifndef SYS_pidfd_open
+#define SYS_pidfd_open 434
+#endif
+
+int launch_mode = LAUNCH_FORK;
+
+static struct launch_stats launch_stats;
+
+static double elapsed(const struct timespec *from, const struct timespec *to)
+{
+    return (to->tv_sec - from->tv_sec) + (to->tv_nsec - from->tv_nsec) / 1e9;
+}
+
+static uint64_t ts_ns(const struct timespec *t)
+{
+    return (uint64_t)t->tv_sec * 1000000000ULL + t->tv_nsec;
+}
+
+static void launch_account(const struct rusage *ru,
+                           const struct timespec *start,
+                           const struct timespec *launched,
+                           const struct timespec *end)
+{
+    double launch = elapsed(start, launched);
+
+    launch_stats.launches++;
+    launch_stats.minflt += ru->ru_minflt;
+    launch_stats.majflt += ru->ru_majflt;
+    launch_stats.cpu += ru->ru_utime.tv_sec + ru->ru_utime.tv_usec / 1e6 +
+                        ru->ru_stime.tv_sec + ru->ru_stime.tv_usec / 1e6;
+    launch_stats.launch += launch;
+    if (launch > launch_stats.launch_max) launch_stats.launch_max = launch;
+    launch_stats.step += elapsed(start, end);
+}
+
+/*
+ * Add this worker's launches to to, for the parent to report
+ */
+void launch_merge(struct launch_stats *to)
+{
+    struct rusage self;
+
+    getrusage(RUSAGE_SELF, &self);
+    to->launches += launch_stats.launches;
+    to->minflt += launch_stats.minflt;
+    to->majflt += launch_stats.majflt;
+    to->cpu += launch_stats.cpu;
+    to->launch += launch_stats.launch;
+    if (launch_stats.launch_max > to->launch_max) {
+        to->launch_max = launch_stats.launch_max;
+    }
+    to->step += launch_stats.step;
+    if (self.ru_maxrss > to->maxrss) to->maxrss = self.ru_maxrss;
+}
+
+/*
+ * Take the workers' merged launches as this process's own
+ */
+void launch_adopt(const struct launch_stats *from)
+{
+    launch_stats = *from;
+}
+
+/*
+ * Print what the helper launches cost, as seen in their rusage and in the
+ * time the runner spent blocked in fork()/posix_spawn()
+ */
+void launch_report(void)
+{
+    unsigned long n = launch_stats.launches;
+    struct rusage self;
+
+    if (n == 0) return;
+    getrusage(RUSAGE_SELF, &self);
+    if (launch_stats.maxrss > self.ru_maxrss) {
+        self.ru_maxrss = launch_stats.maxrss;
+    }
+    fprintf(stderr, "helper launches: %lu, per launch: %.1f minor faults, "
+            "%.1f major faults, %.3f ms cpu\n", n,
+            (double)launch_stats.minflt / n, (double)launch_stats.majflt / n,
+            launch_stats.cpu * 1000 / n);
+    fprintf(stderr, "launch path %s: launch %.1f us mean, %.1f us max; "
+            "step %.3f ms mean; runner maxrss %ld kB\n",
+            (launch_mode == LAUNCH_SPAWN) ? "posix_spawn" : "fork",
+            launch_stats.launch * 1e6 / n, launch_stats.launch_max * 1e6,
+            launch_stats.step * 1e3 / n, self.ru_maxrss);
+}
+
+/*
+ * Start a helper without copying the runner: the exec context is set on
+ * this thread, inherited by the vfork-style child posix_spawn() creates,
+ * and cleared again once the helper has been exec'd.
+ */
+static pid_t spawn_to_lvl(const char *lvl, char * const argv[])
+{
+    extern char **environ;
+    pid_t pid;
+    int status;
+    int i;
+
+    chcon_to_level(lvl);
+    fprintf(stderr, "Spawning: ");
+    for(i=0; argv[i] != NULL; i++) {
+        fprintf(stderr, "%s ", argv[i]);
+    }
+    fprintf(stderr, "\n");
+
+    status = posix_spawnp(&pid, argv[0], NULL, NULL, argv, environ);
+    setexeccon(NULL);
+    if (status != 0) {
+        errno = status;
+        perror("posix_spawn failed");
+        return -1;
+    }
+    return pid;
+}
+
+/*
+ * Start argv[0] at level lvl and return without waiting for it
+ *
+ * Returns 0, or -1 if nothing was started
+ */
+int child_launch(struct mls_child *c, const char *lvl, char * const argv[])
+{
+    const struct level_context *ctx = NULL;
+    size_t len = 0;
+    int i;
+
+    memset(c, 0, sizeof(*c));
+    c->pidfd = -1;
+    snprintf(c->lvl, sizeof(c->lvl), "%s", lvl);
+    for (i = 0; argv[i] != NULL && len < sizeof(c->what); i++) {
+        len += snprintf(c->what + len, sizeof(c->what) - len, "%s%s",
+                        i ? " " : "", argv[i]);
+    }
+
+    fflush(stdout); fflush(stderr);
+    clock_gettime(CLOCK_MONOTONIC, &c->start);
+    if (launch_mode == LAUNCH_SPAWN) {
+        c->pid = spawn_to_lvl(lvl, argv);
+    } else {
+        // look the context up here, so the cache counts it
+        ctx = level_context(lvl);
+        c->pid = fork();
+    }
+    switch(c->pid) 
+    {
+        case -1:
+            perror("launch failed");
+            return -1;
+        case 0:
+            chcon_to_context(ctx);
+            fprintf(stderr, "Running: ");
+            for(i=0; argv[i] != NULL; i++) {
+                fprintf(stderr, "%s ", argv[i]);
+            }
+            fprintf(stderr, "\n");
+            execvp(argv[0], argv);
+            fprintf(stderr, "got past exec()\n");
+            perror("exec failed");
+            CU_FAIL("got past exec");
+            exit(-1);
+            break;
+        default:
+            clock_gettime(CLOCK_MONOTONIC, &c->launched);
+            fprintf(stderr, "child pid is %i\n", c->pid);
+            phase_child(c->pid, ts_ns(&c->launched), 0);
+            c->pidfd = syscall(SYS_pidfd_open, c->pid, 0);
+            break;
+    }
+    return 0;
+}
+
+
+/*
+ * Collect the exit status and rusage of an exited child
+ *
+ * Returns 1 if it was reaped, 0 if it is still running
+ */
+static int child_reap(struct mls_child *c, int options)
+{
+    pid_t pid;
+
+    do {
+        pid = wait4(c->pid, &c->status, options, &c->ru);
+    } while (pid == -1 && errno == EINTR);
+    if (pid == 0) return 0;
+    if (pid == -1) {
+        perror("wait4 failed");
+        c->status = -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &c->end);
+    if (c->pidfd >= 0) close(c->pidfd);
+    c->pidfd = -1;
+    c->done = 1;
+    if (pid != -1) {
+        launch_account(&c->ru, &c->start, &c->launched, &c->end);
+        phase_add("launch", ts_ns(&c->launched) - ts_ns(&c->start));
+        phase_child(c->pid, ts_ns(&c->launched), ts_ns(&c->end));
+    }
+    report_step(c->what, c->lvl,
+                WIFEXITED(c->status) ? WEXITSTATUS(c->status) :
+                WIFSIGNALED(c->status) ? 128 + WTERMSIG(c->status) : -1,
+                (c->end.tv_sec - c->start.tv_sec) +
+                (c->end.tv_nsec - c->start.tv_nsec) / 1e9);
+    return 1;
+}
+
+
+/*
+ * Block until the child exits
+ */
+int child_wait(struct mls_child *c)
+{
+    struct pollfd pfd;
+
+    if (c->done) return 0;
+    if (c->pidfd >= 0) {
+        pfd.fd = c->pidfd;
+        pfd.events = POLLIN;
+        while (poll(&pfd, 1, -1) == -1 && errno == EINTR)
+            ;
+    }
+    child_reap(c, 0);
+    return 0;
+}
+
+
+/*
+ * Report how the child ended, asserting that it exited with status 0
+ */
+int child_exit_ok(const struct mls_child *c)
+{
+    if (WIFEXITED(c->status)) {
+        fprintf(stderr, "child %d exited with status %d\n", c->pid,
+                WEXITSTATUS(c->status));
+        CU_ASSERT_EQUAL(WEXITSTATUS(c->status), 0);
+        return WEXITSTATUS(c->status) == 0;
+    } else if (WIFSIGNALED(c->status)) {
+        fprintf(stderr, "child %d exited from signal %d\n", c->pid,
+                WTERMSIG(c->status));
+        CU_ASSERT(1 == 0);
+    } else {
+        fprintf(stderr, "child %d exited somehow\n", c->pid);
+        CU_ASSERT(1 == -1);            
+    }
+    return 0;
+}
+
+
+int child_set_init(struct child_set *set)
+{
+    set->running = 0;
+    set->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (set->epfd < 0) {
+        perror("epoll_create1 failed");
+        return -1;
+    }
+    return 0;
+}
+
+
+/*
+ * Watch a launched child. Needs a kernel with pidfd_open() (5.3+).
+ */
+int child_set_add(struct child_set *set, struct mls_child *c)
+{
+    struct epoll_event ev;
+
+    if (c->pidfd < 0) {
+        fprintf(stderr, "child %d has no pidfd to watch\n", c->pid);
+        return -1;
+    }
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    if (epoll_ctl(set->epfd, EPOLL_CTL_ADD, c->pidfd, &ev) != 0) {
+        perror("epoll_ctl failed");
+        return -1;
+    }
+    set->running++;
+    return 0;
+}
+
+
+/*
+ * Wait up to timeout_ms (-1 for ever) for any watched child to exit
+ *
+ * Returns the reaped child, or NULL on timeout or when none is running
+ */
+struct mls_child *child_set_next(struct child_set *set, int timeout_ms)
+{
+    struct epoll_event ev;
+    struct mls_child *c;
+    int n;
+
+    while (set->running > 0) {
+        n = epoll_wait(set->epfd, &ev, 1, timeout_ms);
+        if (n == -1 && errno == EINTR) continue;
+        if (n <= 0) return NULL;
+
+        c = ev.data.ptr;
+        epoll_ctl(set->epfd, EPOLL_CTL_DEL, c->pidfd, NULL);
+        set->running--;
+        child_reap(c, 0);
+        return c;
+    }
+    return NULL;
+}
+
+
+void child_set_close(struct child_set *set)
+{
+    if (set->epfd >= 0) close(set->epfd);
+    set->epfd = -1;
+}
+
+
+/*
+ * Launch n helpers at once (argvs[i] at lvls[i]) and reap them as they
+ * exit. Children without a pidfd are waited for in turn at the end.
+ *
+ * Returns the number of children that exited with status 0
+ */
+int run_children(struct mls_child *children, int n,
+                 const char *lvls[], char * const *argvs[])
+{
+    struct child_set set;
+    struct mls_child *c;
+    int ok = 0;
+    int i;
+
+    if (child_set_init(&set) != 0) return 0;
+    for (i = 0; i < n; i++) {
+        if (child_launch(&children[i], lvls[i], argvs[i]) != 0) {
+            CU_FAIL("launch failed");
+            children[i].done = 1;
+            continue;
+        }
+        child_set_add(&set, &children[i]);
+    }
+    while ((c = child_set_next(&set, -1)) != NULL) {
+        ok += child_exit_ok(c);
+    }
+    for (i = 0; i < n; i++) {
+        if (!children[i].done) {
+            child_wait(&children[i]);
+            ok += child_exit_ok(&children[i]);
+        }
+    }
+    child_set_close(&set);
+    return ok;
+}
@@ -0,0 +1,70 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_CHILD_H__
+#define __TEST_MLS_CHILD_H__
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include "mls_support.h"
+
+struct launch_stats {
+    unsigned long launches;     // helpers forked and reaped
+    unsigned long minflt;       // minor page faults, summed over helpers
+    unsigned long majflt;       // major page faults, summed over helpers
+    double cpu;                 // user + system seconds, summed over helpers
+    double launch;              // seconds the runner spent starting helpers
+    double launch_max;
+    double step;                // seconds from launch to reaping the helper
+    long maxrss;                // largest worker, in kB, once merged
+};
+
+#define LAUNCH_FORK  0          // fork, then chcon_to_level() in the child
+#define LAUNCH_SPAWN 1          // setexeccon() here, then posix_spawn()
+extern int launch_mode;
+
+/* A helper launched at a level, tracked through a pidfd */
+struct mls_child {
+    pid_t pid;
+    int pidfd;                  // -1 if the kernel has no pidfd_open()
+    char lvl[MAX_STRING];
+    char what[MAX_STRING];      // the command line, for the reporters
+    int done;                   // reaped; status and ru are valid
+    int status;                 // wait status
+    struct rusage ru;
+    struct timespec start;      // launch began
+    struct timespec launched;   // fork()/posix_spawn() returned
+    struct timespec end;        // reaped
+    void *data;                 // caller's cookie
+};
+
+/* Children watched together from one epoll instance */
+struct child_set {
+    int epfd;
+    int running;
+};
+
+void launch_report(void);
+void launch_merge(struct launch_stats *to);
+void launch_adopt(const struct launch_stats *from);
+
+int child_launch(struct mls_child *c, const char *lvl, char * const argv[]);
+int child_wait(struct mls_child *c);
+int child_exit_ok(const struct mls_child *c);
+
+int child_set_init(struct child_set *set);
+int child_set_add(struct child_set *set, struct mls_child *c);
+struct mls_child *child_set_next(struct child_set *set, int timeout_ms);
+void child_set_close(struct child_set *set);
+
+int run_children(struct mls_child *children, int n,
+                 const char *lvls[], char * const *argvs[]);
+
+#endif
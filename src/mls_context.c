@@ -0,0 +1,246 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Contexts for levels, and fixtures created at a level. Kept apart from
+ * the CUnit support code so mls_bench can link it too.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <selinux/selinux.h>
+#include <selinux/context.h> // for context-mangling functions
+#include "mls_support.h"
+
+/**
+ * Construct from the current range and specified desired level a resulting
+ * range. If the specified level is a range, return that. If it is not, then
+ * construct a range with level as the sensitivity and clearance of the current
+ * context.
+ *
+ * newlevel - the level specified on the command line
+ * range    - the range in the current context
+ *
+ * Returns malloc'd memory
+ */
+char *build_new_range(const char *newlevel, const char *range)
+{
+    char *newrangep = NULL;
+    const char *tmpptr;
+    size_t len;
+
+    // a missing or empty string
+    if (!range || !strlen(range) || !newlevel || !strlen(newlevel))
+        return NULL;
+
+    // if the newlevel is actually a range - just use that
+    if (strchr(newlevel, '-')) {
+        newrangep = strdup(newlevel);
+        return newrangep;
+    }
+
+    // look for MLS range in current context
+    tmpptr = strchr(range, '-');
+    if (tmpptr) {
+        /* we are inserting into a ranged MLS context */
+        len = strlen(newlevel) + 1 + strlen(tmpptr + 1) + 1;
+        newrangep = (char *)malloc(len);
+        if (!newrangep)
+            return NULL;
+        snprintf(newrangep, len, "%s-%s", newlevel, tmpptr + 1);
+    } else {
+        // we are inserting into a currently non-ranged MLS context
+        if (!strcmp(newlevel, range)) {
+            newrangep = strdup(range);
+        } else {
+            len = strlen(newlevel) + 1 + strlen(range) + 1;
+            newrangep = (char *)malloc(len);
+            if (!newrangep)
+                return NULL;
+            snprintf(newrangep, len, "%s-%s", newlevel, range);
+        }
+    }
+
+    return newrangep;
+}
+
+
+/*
+ * Context cache. Every context the runner hands to setexeccon() or
+ * setfscreatecon() is derived from its own context and a level, so each
+ * level's pair of contexts is built once and reused for every launch and
+ * fixture after that.
+ */
+static security_context_t base_ctx = NULL;
+static struct level_context contexts[MAX_LEVELS];
+static int ncontexts = 0;
+static int ncontexts_init = 0;      // built by context_cache_init()
+static unsigned int contexts_reused = 0;
+static struct context_stats merged;
+
+/*
+ * Build the context string for lvl with the given role and type
+ *
+ * Returns malloc'd memory, or NULL
+ */
+static char *build_context(const char *lvl, const char *role,
+                           const char *type)
+{
+    context_t ctx = NULL;
+    char *new_range = NULL;
+    char *str = NULL;
+
+    if (base_ctx == NULL && getcon(&base_ctx) != 0) return NULL;
+    ctx = context_new(base_ctx);
+    if (ctx == NULL) return NULL;
+
+    new_range = build_new_range(lvl, context_range_get(ctx));
+    if (new_range != NULL &&
+        context_range_set(ctx, new_range) == 0 &&
+        context_user_set(ctx, "mls_test_u") == 0 &&
+        context_role_set(ctx, role) == 0 &&
+        context_type_set(ctx, type) == 0 &&
+        context_str(ctx) != NULL) {
+        str = strdup(context_str(ctx));
+    }
+    free(new_range);
+    context_free(ctx);
+    return str;
+}
+
+/*
+ * Find the contexts for lvl, building them on first use
+ *
+ * Returns an entry of the cache, or NULL
+ */
+const struct level_context *level_context(const char *lvl)
+{
+    struct level_context *c;
+    int i;
+
+    for (i = 0; i < ncontexts; i++) {
+        if (!strcmp(contexts[i].lvl, lvl)) {
+            contexts_reused++;
+            return &contexts[i];
+        }
+    }
+    if (ncontexts == MAX_LEVELS) {
+        fprintf(stderr, "context cache full, cannot add '%s'\n", lvl);
+        return NULL;
+    }
+
+    c = &contexts[ncontexts];
+    snprintf(c->lvl, sizeof(c->lvl), "%s", lvl);
+    c->proc = build_context(lvl, "user_r", "user_t");
+    c->file = build_context(lvl, "object_r", "user_home_t");
+    c->ring = build_context(lvl, "object_r", "mls_event_ring_t");
+    if (c->proc == NULL || c->file == NULL || c->ring == NULL) {
+        fprintf(stderr, "could not build contexts for '%s'\n", lvl);
+        free(c->proc);
+        free(c->file);
+        free(c->ring);
+        return NULL;
+    }
+    fprintf(stderr, "contexts for %s: '%s', '%s'\n", lvl, c->proc, c->file);
+    ncontexts++;
+    return c;
+}
+
+/*
+ * Build the contexts of the levels every suite uses, before any worker or
+ * helper is forked, so they all inherit the table
+ */
+int context_cache_init(void)
+{
+    if (level_context(LVL_LOW) == NULL) return -1;
+    if (level_context(LVL_HIGH) == NULL) return -1;
+    if (level_context(LVL_SYSLOW) == NULL) return -1;
+    ncontexts_init = ncontexts;
+    contexts_reused = 0;
+    return 0;
+}
+
+/*
+ * Add what this worker built and reused to to; the contexts it inherited
+ * from the init are counted once, by the parent
+ */
+void context_merge(struct context_stats *to)
+{
+    to->built += ncontexts - ncontexts_init;
+    to->reused += contexts_reused;
+}
+
+void context_adopt(const struct context_stats *from)
+{
+    merged = *from;
+}
+
+void context_report(void)
+{
+    if (ncontexts + merged.built == 0) return;
+    fprintf(stderr, "contexts: %u built, %u builds avoided\n",
+            ncontexts + merged.built, contexts_reused + merged.reused);
+}
+
+
+/*
+ * Create a file at a new level
+ */
+int create_file(const char *lvl, const char *path, const char *data)
+{
+    const struct level_context *c = level_context(lvl);
+    int status = 0;
+    FILE *file = NULL;
+
+    if (c == NULL) return -1;
+    fprintf(stderr, "writing file '%s' with context '%s'\n", path, c->file);
+    status = setfscreatecon(c->file);
+    if (status != 0) return -1;
+
+    file = fopen(path, "a+");
+    if (file == NULL) {
+        perror("fopen failed");
+        return -1;
+    }
+    fprintf(stderr, "opened file '%s' with context '%s'\n", path, c->file);
+
+    if (data != NULL) {
+        status = fprintf(file, "%s", data);
+        if (status != (int)strlen(data)) {
+            fprintf(stderr, "fprintf(): %d (%s)\n", errno, strerror(errno));
+            fclose(file);
+            return -1;
+        }
+    }
+    fclose(file);
+    return 0;
+}
+
+/*
+ * Create a FIFO at a new level
+ */
+int create_fifo(const char *lvl, const char *path)
+{
+    const struct level_context *c = level_context(lvl);
+    int status = 0;
+
+    if (c == NULL) return -1;
+    fprintf(stderr, "writing file '%s' with context '%s'\n", path, c->file);
+    status = setfscreatecon(c->file);
+    if (status != 0) return -1;
+
+    status = mkfifo(path, S_IRWXU|S_IRWXG|S_IRWXO);
+    if (status != 0) {
+        perror("mkfifo failed");
+        return -1;
+    }
+    fprintf(stderr, "created file '%s' with context '%s'\n", path, c->file);
+    return 0;
+}
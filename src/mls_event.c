@@ -0,0 +1,353 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Helper event log. Instead of appending text to a shared log, a helper
+ * writes fixed-size records into a ring kept in a file at its own level,
+ * so it only ever writes at its level. The runner, whose clearance
+ * dominates every level, maps each ring read-only and drains the records
+ * it has not seen into one binary run log; it never writes to a ring, so
+ * its read position is its own. mls_events turns a run log, or a ring,
+ * back into text.
+ *
+ * Helpers also record phases: EVENT_PHASE() at the top of a function
+ * records how long the function took when it returns.
+ *
+ * Writers claim a slot by bumping the ring's head and publish it by
+ * storing its sequence number last. A reader that falls more than a ring
+ * behind counts the overwritten records as lost.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <stddef.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "mls_event.h"
+
+// helper side: this process's ring and its start record
+static struct event_ring *own_ring = NULL;
+static struct event_rec own;
+static uint64_t main_ns = 0;    // when main() was entered
+
+// runner side: every ring drained into the run log
+struct event_reader {
+    char path[256];
+    const struct event_ring *ring;
+    uint64_t tail;              // next position to drain
+};
+static struct event_reader readers[EVENT_RINGS];
+static int nreaders = 0;
+static FILE *event_out = NULL;
+static char event_out_path[256];
+static unsigned long long drained = 0;
+static unsigned long long lost = 0;
+
+// runner side: a phase event_wait() is looking for
+static int watch_pid = 0;
+static const char *watch_prefix = NULL;
+static int watch_seen = 0;
+
+void (*event_hook)(const struct event_rec *r) = NULL;
+
+
+uint64_t event_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void event_put(struct event_ring *ring, const struct event_rec *r)
+{
+    uint64_t n = __atomic_fetch_add(&ring->head, 1, __ATOMIC_RELAXED);
+    struct event_rec *slot = &ring->slots[n % ring->nslots];
+
+    __atomic_store_n(&slot->seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    memcpy((char *)slot + sizeof(slot->seq), (const char *)r + sizeof(r->seq),
+           sizeof(*r) - sizeof(r->seq));
+    __atomic_store_n(&slot->seq, n + 1, __ATOMIC_RELEASE);
+}
+
+static void event_exit(int status, void *arg)
+{
+    int err = errno;
+
+    (void)arg;
+    own.type = EV_EXIT;
+    own.ts_ns = event_now();
+    own.err = err;
+    own.status = status;
+    event_put(own_ring, &own);
+}
+
+
+/*
+ * Called first thing in main(), so the start record shows how long the
+ * helper took to get going
+ */
+void event_main(void)
+{
+    main_ns = event_now();
+}
+
+/*
+ * Map the ring at path and record this helper's start; its exit is
+ * recorded, with the status and errno, when it exits.
+ */
+int event_open(const char *path, const char *driver, int test,
+               const char *lvl, const char *obj)
+{
+    size_t len;
+    int fd;
+
+    fd = open(path, O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open event ring failed");
+        return -1;
+    }
+    own_ring = mmap(NULL, sizeof(*own_ring), PROT_READ | PROT_WRITE,
+                    MAP_SHARED, fd, 0);
+    close(fd);
+    if (own_ring == MAP_FAILED || own_ring->magic != EVENT_MAGIC) {
+        fprintf(stderr, "'%s' is not an event ring\n", path);
+        own_ring = NULL;
+        return -1;
+    }
+
+    memset(&own, 0, sizeof(own));
+    own.ts_ns = event_now();
+    own.start_ns = main_ns ? main_ns : own.ts_ns;
+    own.pid = getpid();
+    own.type = EV_START;
+    own.test = test;
+    snprintf(own.driver, sizeof(own.driver), "%s", driver);
+    snprintf(own.lvl, sizeof(own.lvl), "%s", lvl);
+    len = strlen(obj);
+    if (len >= sizeof(own.obj)) obj += len - sizeof(own.obj) + 1;
+    snprintf(own.obj, sizeof(own.obj), "%s", obj);
+    event_put(own_ring, &own);
+    on_exit(event_exit, NULL);
+    return 0;
+}
+
+
+void event_phase_end(struct event_phase *p)
+{
+    event_phase_add(p->name, p->start_ns, event_now());
+}
+
+/*
+ * Record a phase timed by the caller, such as one that began in another
+ * process
+ */
+void event_phase_add(const char *name, uint64_t start_ns, uint64_t end_ns)
+{
+    struct event_rec r;
+
+    if (own_ring == NULL) return;
+    r = own;
+    r.type = EV_PHASE;
+    r.start_ns = start_ns;
+    r.ts_ns = end_ns;
+    snprintf(r.obj, sizeof(r.obj), "%s", name);
+    event_put(own_ring, &r);
+}
+
+
+/*
+ * Make an empty ring at path, keeping one that is already there. The
+ * caller sets the file creation context.
+ */
+int event_ring_create(const char *path)
+{
+    static struct event_ring head = {
+        .magic = EVENT_MAGIC, .nslots = EVENT_SLOTS, .head = 0
+    };
+    static struct event_ring old;
+    size_t hlen = offsetof(struct event_ring, slots);
+    struct stat st;
+    int fd;
+
+    fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0666);
+    if (fd < 0) {
+        perror("open event ring failed");
+        return -1;
+    }
+    if (fstat(fd, &st) == 0 && st.st_size == sizeof(struct event_ring) &&
+        pread(fd, &old, hlen, 0) == (ssize_t)hlen &&
+        old.magic == EVENT_MAGIC && old.nslots == EVENT_SLOTS) {
+        close(fd);
+        return 0;
+    }
+    if (ftruncate(fd, 0) != 0 ||
+        ftruncate(fd, sizeof(struct event_ring)) != 0 ||
+        pwrite(fd, &head, hlen, 0) != (ssize_t)hlen) {
+        perror("initializing event ring failed");
+        close(fd);
+        return -1;
+    }
+    close(fd);
+    return 0;
+}
+
+/*
+ * Map a ring read-only for draining, starting from what is in it now
+ */
+int event_attach(const char *path)
+{
+    struct event_reader *r;
+    void *map;
+    int fd;
+    int i;
+
+    for (i = 0; i < nreaders; i++) {
+        if (strcmp(readers[i].path, path) == 0) return 0;
+    }
+    if (nreaders == EVENT_RINGS) {
+        fprintf(stderr, "too many event rings\n");
+        return -1;
+    }
+
+    fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        perror("open event ring failed");
+        return -1;
+    }
+    map = mmap(NULL, sizeof(struct event_ring), PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        perror("mmap event ring failed");
+        return -1;
+    }
+
+    r = &readers[nreaders++];
+    snprintf(r->path, sizeof(r->path), "%s", path);
+    r->ring = map;
+    r->tail = __atomic_load_n(&r->ring->head, __ATOMIC_ACQUIRE);
+    return 0;
+}
+
+/*
+ * Where drained records go; the run log is started afresh
+ */
+int event_output(const char *path)
+{
+    if (event_out != NULL && strcmp(event_out_path, path) == 0) return 0;
+    if (event_out != NULL) fclose(event_out);
+    event_out = fopen(path, "w");
+    if (event_out == NULL) {
+        perror("open event log failed");
+        return -1;
+    }
+    snprintf(event_out_path, sizeof(event_out_path), "%s", path);
+    return 0;
+}
+
+
+/*
+ * Copy every record published since the last drain into the run log
+ */
+void event_drain(void)
+{
+    struct event_reader *r;
+    struct event_rec rec;
+    const struct event_rec *slot;
+    uint64_t head, seq;
+    int i;
+
+    for (i = 0; i < nreaders; i++) {
+        r = &readers[i];
+        head = __atomic_load_n(&r->ring->head, __ATOMIC_ACQUIRE);
+        if (head - r->tail > r->ring->nslots) {
+            lost += head - r->ring->nslots - r->tail;
+            r->tail = head - r->ring->nslots;
+        }
+        while (r->tail < head) {
+            slot = &r->ring->slots[r->tail % r->ring->nslots];
+            seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+            if (seq == 0 || seq <= r->tail) break;   // not published yet
+            memcpy(&rec, slot, sizeof(rec));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (seq != r->tail + 1 ||
+                __atomic_load_n(&slot->seq, __ATOMIC_RELAXED) != seq) {
+                lost++;                 // overwritten while we looked
+            } else {
+                if (event_out != NULL) fwrite(&rec, sizeof(rec), 1, event_out);
+                if (event_hook != NULL) event_hook(&rec);
+                if (rec.pid == watch_pid && rec.type == EV_PHASE &&
+                    strncmp(rec.obj, watch_prefix,
+                            strlen(watch_prefix)) == 0) {
+                    watch_seen = 1;
+                }
+                drained++;
+            }
+            r->tail++;
+        }
+    }
+    if (event_out != NULL) fflush(event_out);
+}
+
+/*
+ * Drain until helper pid has recorded a phase whose name starts with
+ * prefix, or ms have passed; for a step that must follow another helper's
+ * progress
+ *
+ * Returns 1 if it did, 0 if not
+ */
+int event_wait(int pid, const char *prefix, int ms)
+{
+    uint64_t end = event_now() + (uint64_t)ms * 1000000ULL;
+    struct timespec nap = { 0, 100000 };
+
+    watch_pid = pid;
+    watch_prefix = prefix;
+    watch_seen = 0;
+    for (;;) {
+        event_drain();
+        if (watch_seen || event_now() >= end) break;
+        nanosleep(&nap, NULL);
+    }
+    watch_pid = 0;
+    return watch_seen;
+}
+
+void event_report(void)
+{
+    event_drain();
+    if (nreaders == 0) return;
+    fprintf(stderr, "events: %llu drained from %d rings into %s, %llu lost\n",
+            drained, nreaders, event_out_path, lost);
+}
+
+
+void event_print(FILE *out, const struct event_rec *r)
+{
+    fprintf(out, "%llu.%09llu %6d %-5s %2d %-8s ",
+            (unsigned long long)(r->ts_ns / 1000000000ULL),
+            (unsigned long long)(r->ts_ns % 1000000000ULL),
+            r->pid, r->driver, r->test, r->lvl);
+    if (r->type == EV_START) {
+        fprintf(out, "start %s after %.3f ms\n", r->obj,
+                (r->ts_ns - r->start_ns) / 1e6);
+    } else if (r->type == EV_PHASE) {
+        fprintf(out, "phase %s %.3f ms\n", r->obj,
+                (r->ts_ns - r->start_ns) / 1e6);
+    } else {
+        fprintf(out, "exit  %s status %d errno %d (%s) after %.3f ms\n",
+                r->obj, r->status, r->err, strerror(r->err),
+                (r->ts_ns - r->start_ns) / 1e6);
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_EVENT_H__
+#define __TEST_MLS_EVENT_H__
+#include <stdio.h>
+#include <stdint.h>
+
+#define EVENT_MAGIC  0x45534c4d     // "MLSE"
+#define EVENT_SLOTS  256
+#define EVENT_RINGS  64
+
+enum event_type { EV_START, EV_EXIT, EV_PHASE };
+
+/* One helper event; rings and the drained run log hold these as is */
+struct event_rec {
+    uint64_t seq;               // ring position + 1, published last
+    uint64_t ts_ns;             // CLOCK_MONOTONIC
+    uint64_t start_ns;          // when the helper, or the phase, started
+    int32_t pid;
+    int16_t type;               // enum event_type
+    int16_t test;               // --test number
+    int32_t err;                // errno at exit
+    int32_t status;             // exit status
+    char driver[8];
+    char lvl[32];               // the helper's level, truncated
+    char obj[64];               // --file, truncated from the left; or phase
+};
+
+/* A ring is a file at the level of the helpers that write it */
+struct event_ring {
+    uint32_t magic;
+    uint32_t nslots;
+    uint64_t head;              // next position, claimed by the writers
+    struct event_rec slots[EVENT_SLOTS];
+};
+
+/* A phase in progress; see EVENT_PHASE() */
+struct event_phase {
+    const char *name;
+    uint64_t start_ns;
+};
+
+/*
+ * Time the rest of the enclosing block as a phase named after the
+ * function. Nothing is recorded if the helper exits inside it.
+ */
+#define EVENT_PHASE() \
+    struct event_phase __phase __attribute__((cleanup(event_phase_end))) = \
+        { __func__, event_now() }
+
+// helper side
+uint64_t event_now(void);
+void event_main(void);
+int event_open(const char *path, const char *driver, int test,
+               const char *lvl, const char *obj);
+void event_phase_end(struct event_phase *p);
+void event_phase_add(const char *name, uint64_t start_ns, uint64_t end_ns);
+
+// runner side
+extern void (*event_hook)(const struct event_rec *r);
+int event_ring_create(const char *path);
+int event_attach(const char *path);
+int event_output(const char *path);
+void event_drain(void);
+int event_wait(int pid, const char *prefix, int ms);
+void event_report(void);
+
+// decoder
+void event_print(FILE *out, const struct event_rec *r);
+
+#endif
@@ -0,0 +1,77 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Event decoder: prints the records of a run log (log/events.bin) or of
+ * a helper ring (log/<level>_events.ring) as text, one line per record.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "mls_event.h"
+
+static struct event_ring ring;
+
+
+/*
+ * A ring holds the last nslots records; print them oldest first
+ */
+static void decode_ring(FILE *f)
+{
+    uint64_t n, first;
+
+    if (fread(&ring, sizeof(ring), 1, f) != 1) {
+        fprintf(stderr, "short ring\n");
+        return;
+    }
+    first = (ring.head > EVENT_SLOTS) ? ring.head - EVENT_SLOTS : 0;
+    for (n = first; n < ring.head; n++) {
+        if (ring.slots[n % EVENT_SLOTS].seq != n + 1) continue;
+        event_print(stdout, &ring.slots[n % EVENT_SLOTS]);
+    }
+}
+
+static void decode_log(FILE *f)
+{
+    struct event_rec r;
+
+    while (fread(&r, sizeof(r), 1, f) == 1) {
+        event_print(stdout, &r);
+    }
+}
+
+
+int main(int argc, char *argv[])
+{
+    uint32_t magic;
+    FILE *f;
+    int i;
+
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <events.bin|ring> ...\n", argv[0]);
+        return -1;
+    }
+    for (i = 1; i < argc; i++) {
+        f = fopen(argv[i], "r");
+        if (f == NULL) {
+            perror(argv[i]);
+            return -1;
+        }
+        // a ring starts with its magic; a run log with a sequence number
+        if (fread(&magic, sizeof(magic), 1, f) == 1) {
+            rewind(f);
+            if (magic == EVENT_MAGIC) {
+                decode_ring(f);
+            } else {
+                decode_log(f);
+            }
+        }
+        fclose(f);
+    }
+    return 0;
+}
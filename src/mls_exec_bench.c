@@ -0,0 +1,99 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Exec cost of a helper binary: forks and execs a command n times and
+ * reports the mean page faults, cpu time and wall time per exec, taken
+ * from each child's rusage. No policy is needed; a helper run without
+ * --test exits right after its startup, which is the part measured.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#define EXECS 1000
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static double tv_us(const struct timeval *tv)
+{
+    return tv->tv_sec * 1e6 + tv->tv_usec;
+}
+
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [-n execs] prog [args...]\n", prog);
+    exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+    struct rusage ru;
+    double minflt = 0, majflt = 0, cpu = 0, start;
+    int execs = EXECS;
+    int status, opt, i, fd;
+    pid_t pid;
+
+    while ((opt = getopt(argc, argv, "+n:")) != -1) {
+        switch (opt) {
+            case 'n':
+                execs = atoi(optarg);
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+    if (optind >= argc || execs <= 0) usage(argv[0]);
+
+    start = now();
+    for (i = 0; i < execs; i++) {
+        pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            return -1;
+        }
+        if (pid == 0) {
+            fd = open("/dev/null", O_WRONLY);
+            if (fd >= 0) {
+                dup2(fd, STDOUT_FILENO);
+                dup2(fd, STDERR_FILENO);
+            }
+            execv(argv[optind], argv + optind);
+            _exit(127);
+        }
+        if (wait4(pid, &status, 0, &ru) != pid) {
+            perror("wait4");
+            return -1;
+        }
+        if (WIFEXITED(status) && WEXITSTATUS(status) == 127) {
+            fprintf(stderr, "cannot exec %s\n", argv[optind]);
+            return -1;
+        }
+        minflt += ru.ru_minflt;
+        majflt += ru.ru_majflt;
+        cpu += tv_us(&ru.ru_utime) + tv_us(&ru.ru_stime);
+    }
+
+    printf("%-28s %6d execs %8.1f minflt %6.2f majflt %8.1f us cpu "
+           "%8.1f us wall\n", argv[optind], execs, minflt / execs,
+           majflt / execs, cpu / execs, (now() - start) * 1e6 / execs);
+    return 0;
+}
@@ -10,10 +10,11 @@
 #ifndef __TEST_MLS_FILE_H__
 #define __TEST_MLS_FILE_H__
 #include <CUnit/CUnit.h>
+#include "mls_matrix.h"
 
 int test_file_init(void);
 int test_file_cleanup(void);
-extern CU_TestInfo file_tests[];
+extern struct matrix_class file_class;
 
 #endif
 
@@ -11,16 +11,15 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
-#include <getopt.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
-#include <selinux/selinux.h>
-#include <selinux/context.h> // for context-mangling functions
 #include "mls_file.h"
 #include "mls_support.h"
+#include "mls_helper.h"
+#include "mls_event.h"
 
-void read_low(int level, const char *fname)
+static void read_low(int level, const char *fname)
 {
     FILE *file = NULL;
     static char buf[10];
@@ -60,7 +59,7 @@ void read_low(int level, const char *fname)
 }
 
 
-void read_high(int level, const char *fname)
+static void read_high(int level, const char *fname)
 {
     FILE *file = NULL;
     static char buf[10];
@@ -101,7 +100,7 @@ void read_high(int level, const char *fname)
 }
 
 
-void write_low(int level, const char *fname)
+static void write_low(int level, const char *fname)
 { 
     FILE *file = NULL;
     int status;
@@ -139,7 +138,7 @@ void write_low(int level, const char *fname)
 }
 
 
-void write_high(int level, const char *fname)
+static void write_high(int level, const char *fname)
 {
     FILE *file = NULL;
     int status;
@@ -179,78 +178,81 @@ void write_high(int level, const char *fname)
 }
 
 
-int main(int argc, char* argv[])
+/*
+ * Read a file whose expected outcome the runner has worked out: 5 expects
+ * to read data back, 6 expects to be denied
+ */
+static void read_expect(int test, const char *fname, const char *data)
 {
-    int opt, option_index;
-    int test_num  = -1;
-    int level = -1;
-    context_t ctx = NULL;
-    security_context_t ctx_check = NULL;
-    char *path = NULL;
-    char *log_path = NULL;
-    time_t t;
+    EVENT_PHASE();
+    FILE *file = NULL;
+    char buf[MAX_STRING];
 
-    static struct option long_options[] = {
-      {"output",  required_argument, 0, 'o'},
-      {"test",    required_argument, 0, 't'},
-      {"file",    required_argument, 0, 'f'},
-      {0, 0, 0, 0}
-    };
-    
-    while ((opt = getopt_long(argc, argv, "o:t:f:",
-                              long_options, &option_index)) != -1)
-    {
-        switch (opt) {            
-            case 'o':
-                log_path = optarg;
-                if (freopen(log_path, "a+", stdout) == NULL) {
-                    exit(-1);
-                }
-                if (freopen(log_path, "a+", stderr) == NULL) {
-                    exit(-1);
-                }
-                break;
-            case 't':
-                test_num = atoi(optarg);
-                break;
-            case 'f':
-                path = optarg;
-                break;
-            default:
-                printf("bad argument.\n");
-                exit(-1);
-            }
-    }     
-
-    if (test_num == -1) {
-        printf("no test specified.\n");
-        exit(-1);
-    } else if (path == NULL) {
-        printf("no path specified.\n");
-        exit(-1);
+    printf("%s(%d, %s)\n", __func__, test, fname);
+
+    file = fopen(fname, "r");
+    if (file == NULL) {
+        perror("fopen failed");
+    }
+    if (test == 6) {
+        assert(file == NULL);
+        printf("PASS\n");
+        return;
     }
+    assert(file != NULL);
 
+    memset(buf, 0, sizeof(buf));
+    fscanf(file, "%127s", buf);
+    fclose(file);
+    printf("File contains: %s\n", data ? data : "(unchecked)");
+    printf("We read:  %s\n", buf);
+    assert(data == NULL || strcmp(buf, data) == 0);
+    printf("PASS\n");
+}
+
+
+/*
+ * Write a file whose expected outcome the runner has worked out: 7 expects
+ * the write to succeed, 8 expects denial, 9 accepts either
+ */
+static void write_expect(int test, const char *fname)
+{
+    EVENT_PHASE();
+    FILE *file = NULL;
+    int status;
+    time_t t;
+
+    printf("%s(%d, %s)\n", __func__, test, fname);
     time(&t);
-    printf("\n%s", ctime(&t));
-    getcon(&ctx_check);
-    printf("Context: '%s'\n", ctx_check); 
-    ctx = context_new(ctx_check);
-    const char *range = context_range_get(ctx);
-
-    if (strncmp(LVL_HIGH"-", range, sizeof(LVL_HIGH"-")-1) == 0) {
-        level = AT_HIGH;
-        printf("process is at high\n");
-    } else if (strncmp(LVL_LOW"-", range, sizeof(LVL_LOW"-")-1) == 0) {
-        level = AT_LOW;
-        printf("process is at low\n");
-    } else {
-        printf("unexpected level\n");
-        exit(-1);
+
+    file = fopen(fname, "a+");
+    if (file == NULL) {
+        perror("fopen failed");
+    }
+    if (test == 7) {
+        assert(file != NULL);
+    } else if (test == 8) {
+        assert(file == NULL);
+    } else if (file != NULL) {
+        printf("Write was allowed\n");
+    }
+
+    if (file) {
+        status = fprintf(file, "%s", ctime(&t));
+        printf("We wrote %d chars\n", status);
+        assert(status > 0);
+        fclose(file);
     }
+    printf("PASS\n");
+}
 
-    fflush(stdout); fflush(stderr);
 
-    switch(test_num) {
+int file_helper(const struct helper_args *args)
+{
+    int level = args->level;
+    char *path = args->path;
+
+    switch(args->test_num) {
         case 1:
             read_low(level, path);
             break;
@@ -263,6 +265,15 @@ int main(int argc, char* argv[])
         case 4:
             write_high(level, path);
             break;
+        case 5:
+        case 6:
+            read_expect(args->test_num, path, args->data);
+            break;
+        case 7:
+        case 8:
+        case 9:
+            write_expect(args->test_num, path);
+            break;
         default:
             printf("invalid test chosen\n");
             exit(-1);
@@ -270,4 +281,3 @@ int main(int argc, char* argv[])
     }
     return 0;
 }
-
@@ -0,0 +1,211 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Multi-call helper. Every object driver lives in this one binary, which
+ * is installed under each of the old helper names; the driver is chosen
+ * from argv[0] (mls_shm_helper ...) or from a subcommand (mls_helper shm
+ * ...). Option parsing, log redirection, level detection and the start
+ * and exit records of --events are done here once for all drivers.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <getopt.h>
+#include <string.h>
+#include <time.h>
+#include <selinux/selinux.h>
+#include <selinux/context.h> // for context-mangling functions
+#include "mls_support.h"
+#include "mls_helper.h"
+#include "mls_serve.h"
+#include "mls_event.h"
+
+static const struct helper_driver drivers[] = {
+    {"file", file_helper},
+    {"shm",  shm_helper},
+    {"msg",  msg_helper},
+    {"sem",  sem_helper},
+    {"pipe", pipe_helper},
+    {NULL, NULL}
+};
+
+static const struct helper_driver *driver = NULL;
+
+
+static const struct helper_driver *find_driver(const char *name, size_t len)
+{
+    const struct helper_driver *d;
+
+    for (d = drivers; d->name != NULL; d++) {
+        if (strlen(d->name) == len && strncmp(d->name, name, len) == 0) {
+            return d;
+        }
+    }
+    return NULL;
+}
+
+
+/*
+ * Pick the driver from the name we were run as: mls_<driver>_helper
+ */
+static const struct helper_driver *driver_from_prog(const char *prog)
+{
+    const char *base = strrchr(prog, '/');
+    size_t len;
+
+    base = base ? base + 1 : prog;
+    len = strlen(base);
+    if (strncmp(base, "mls_", 4) != 0 || len <= strlen("mls__helper") ||
+        strcmp(base + len - strlen("_helper"), "_helper") != 0) {
+        return NULL;
+    }
+    return find_driver(base + 4, len - strlen("mls__helper"));
+}
+
+
+static int run_helper(int argc, char* argv[])
+{
+    context_t ctx = NULL;
+    security_context_t ctx_check = NULL;
+    struct helper_args args;
+    char lvl[MAX_STRING];
+    int opt, option_index;
+    time_t t;
+
+    static struct option long_options[] = {
+      {"output",  required_argument, 0, 'o'},
+      {"test",    required_argument, 0, 't'},
+      {"file",    required_argument, 0, 'f'},
+      {"data",    required_argument, 0, 'd'},
+      {"sysv",    no_argument,       0, 'v'},
+      {"events",  required_argument, 0, 'e'},
+      {0, 0, 0, 0}
+    };
+
+    memset(&args, 0, sizeof(args));
+    args.test_num = -1;
+    args.level = -1;
+
+    while ((opt = getopt_long(argc, argv, "o:t:f:d:ve:",
+                              long_options, &option_index)) != -1)
+    {
+        switch (opt) {            
+            case 'o':
+                args.log_path = optarg;
+                if (freopen(args.log_path, "a+", stdout) == NULL) {
+                    exit(-1);
+                }
+                if (freopen(args.log_path, "a+", stderr) == NULL) {
+                    exit(-1);
+                }
+                break;
+            case 't':
+                args.test_num = atoi(optarg);
+                break;
+            case 'f':
+                args.path = optarg;
+                break;
+            case 'd':
+                args.data = optarg;
+                break;
+            case 'v':
+                args.system_v = 1;
+                break;
+            case 'e':
+                args.events_path = optarg;
+                break;
+            default:
+                printf("bad argument.\n");
+                exit(-1);
+            }
+    }     
+
+    if (args.test_num == -1) {
+        printf("no test specified.\n");
+        exit(-1);
+    } else if (args.path == NULL) {
+        printf("no path specified.\n");
+        exit(-1);
+    }
+
+    // with an event ring and no text log, the records are the log
+    if (args.events_path != NULL && args.log_path == NULL) {
+        if (freopen("/dev/null", "w", stdout) == NULL ||
+            freopen("/dev/null", "w", stderr) == NULL) {
+            exit(-1);
+        }
+    }
+
+    time(&t);
+    printf("\n%s", ctime(&t));
+    printf("%s driver\n", driver->name);
+    getcon(&ctx_check);
+    printf("Context: '%s'\n", ctx_check); 
+    ctx = context_new(ctx_check);
+    const char *range = context_range_get(ctx);
+
+    if (strncmp(LVL_HIGH"-", range, sizeof(LVL_HIGH"-")-1) == 0) {
+        args.level = AT_HIGH;
+        printf("process is at high\n");
+    } else if (strncmp(LVL_LOW"-", range, sizeof(LVL_LOW"-")-1) == 0) {
+        args.level = AT_LOW;
+        printf("process is at low\n");
+    } else {
+        // only tests that are told their expected outcome can run here
+        args.level = AT_OTHER;
+        printf("process is at %s\n", range);
+    }
+
+    if (args.events_path != NULL) {
+        snprintf(lvl, sizeof(lvl), "%.*s", (int)strcspn(range, "-"), range);
+        if (event_open(args.events_path, driver->name, args.test_num, lvl,
+                       args.path) != 0) {
+            exit(-1);
+        }
+    }
+
+    fflush(stdout); fflush(stderr);
+
+    return driver->run(&args);
+}
+
+
+static void usage(const char *prog)
+{
+    const struct helper_driver *d;
+
+    fprintf(stderr, "usage: %s <driver> [options]\n", prog);
+    fprintf(stderr, "       mls_<driver>_helper [options]\n");
+    fprintf(stderr, "drivers:");
+    for (d = drivers; d->name != NULL; d++) {
+        fprintf(stderr, " %s", d->name);
+    }
+    fprintf(stderr, "\n");
+    exit(-1);
+}
+
+
+int main(int argc, char* argv[])
+{
+    event_main();
+    driver = driver_from_prog(argv[0]);
+    if (driver == NULL) {
+        // mls_helper <driver> ...: the driver name stands in for argv[0]
+        if (argc < 2) usage(argv[0]);
+        driver = find_driver(argv[1], strlen(argv[1]));
+        if (driver == NULL) usage(argv[0]);
+        argc--;
+        argv++;
+    }
+
+    if (argc == 3 && strcmp(argv[1], SERVE_OPT) == 0) {
+        return serve_commands(argv[0], argv[2], run_helper);
+    }
+    return run_helper(argc, argv);
+}
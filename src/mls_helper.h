@@ -0,0 +1,74 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_HELPER_H__
+#define __TEST_MLS_HELPER_H__
+#include "mls_support.h"
+
+/* Options shared by every object driver */
+struct helper_args {
+    int test_num;
+    int level;          // AT_LOW, AT_HIGH or AT_OTHER
+    int system_v;       // use System V rather than POSIX objects
+    char *path;
+    char *log_path;
+    char *events_path;  // event ring at this level, or NULL
+    char *data;
+};
+
+typedef int (*helper_func_t)(const struct helper_args *args);
+
+struct helper_driver {
+    const char *name;   // mls_<name>_helper, or mls_helper <name>
+    helper_func_t run;
+};
+
+/* Options for a sized segment */
+#define SEG_HUGE      0x1   // SHM_HUGETLB; a POSIX segment asks for THP
+#define SEG_POPULATE  0x2   // prefault when mapped
+#define SEG_LOCK      0x4   // mlock the mapping
+
+/* Object primitives, used by the drivers and by mls_bench */
+int create_shm(struct shared_space_t **ptr, const char *path, int fail);
+int create_shm_sized(struct shared_space_t **ptr, const char *path,
+                     size_t size, int opts, int fail);
+int attach_shm(int oflag, struct shared_space_t **ptr,
+               const char *path, int fail);
+int attach_shm_sized(int oflag, struct shared_space_t **ptr,
+                     const char *path, size_t size, int opts, int fail);
+int close_shm(const char *path);
+int create_shm_v(struct shared_space_t **ptr, const char *path, int fail);
+int create_shm_v_sized(struct shared_space_t **ptr, const char *path,
+                       size_t size, int opts, int fail);
+int attach_shm_v(int oflag, struct shared_space_t **ptr,
+                 const char *path, int fail);
+int attach_shm_v_sized(int oflag, struct shared_space_t **ptr,
+                       const char *path, size_t size, int opts, int fail);
+int close_shm_v(const char *path);
+int write_shm(struct shared_space_t *segptr, const char *data, int fail);
+int read_shm(struct shared_space_t *segptr, const char *data, int fail);
+int create_msgq(const char *path, int fail);
+int attach_msgq(int oflag, const char *path, int fail);
+int close_msgq(const char *path, int fail);
+int write_msg(int id, const char *data, int fail);
+int read_msg(int id, const char *data, int fail);
+int create_sem(const char *path, int fail);
+int create_sem_set(const char *path, int nsems, int fail);
+int attach_sem(int oflag, const char *path, int fail);
+int close_sem(const char *path, int fail);
+int write_sem(int id, const char *data, int fail);
+int read_sem(int id, const char *data, int fail);
+
+int file_helper(const struct helper_args *args);
+int shm_helper(const struct helper_args *args);
+int msg_helper(const struct helper_args *args);
+int sem_helper(const struct helper_args *args);
+int pipe_helper(const struct helper_args *args);
+
+#endif
@@ -0,0 +1,144 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Dominance oracle. A level is a sensitivity and a 1024-bit category map,
+ * so dominance is one compare and sixteen word-wide and-nots, with no
+ * allocation and no string handling after the level is parsed. The
+ * runner uses it for the expected outcome of every generated test.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdlib.h>
+#include <string.h>
+#include "mls_level.h"
+
+#define MLS_MAX_SENS 1023
+
+
+static int parse_num(const char **p, long max, long *val)
+{
+    char *end;
+
+    if (**p < '0' || **p > '9') return -1;
+    *val = strtol(*p, &end, 10);
+    if (*val > max) return -1;
+    *p = end;
+    return 0;
+}
+
+/*
+ * Parse one level, s<N>[:c<a>[.c<b>][,...]], stopping at the end of the
+ * string or at a '-'
+ *
+ * Returns the number of characters used, or -1 if str is not a level
+ */
+static int level_parse(const char *str, struct mls_level *l)
+{
+    const char *p = str;
+    long sens, a, b;
+
+    memset(l, 0, sizeof(*l));
+    if (*p++ != 's' || parse_num(&p, MLS_MAX_SENS, &sens) != 0) return -1;
+    l->sens = (int)sens;
+
+    if (*p == ':') {
+        do {
+            p++;
+            if (*p++ != 'c' || parse_num(&p, MLS_CATS - 1, &a) != 0) {
+                return -1;
+            }
+            b = a;
+            if (*p == '.') {
+                p++;
+                if (*p++ != 'c' || parse_num(&p, MLS_CATS - 1, &b) != 0 ||
+                    b < a) {
+                    return -1;
+                }
+            }
+            for (; a <= b; a++) {
+                l->cats[a / 64] |= (uint64_t)1 << (a % 64);
+            }
+        } while (*p == ',');
+    }
+    if (*p != '\0' && *p != '-') return -1;
+    return (int)(p - str);
+}
+
+/*
+ * Returns 0, or -1 if str is not a single level
+ */
+int mls_level_parse(const char *str, struct mls_level *l)
+{
+    int n = level_parse(str, l);
+
+    return (n < 0 || str[n] != '\0') ? -1 : 0;
+}
+
+/*
+ * Parse low[-high]; a single level is a range of one
+ *
+ * Returns 0, or -1 if str is not a range or high does not dominate low
+ */
+int mls_range_parse(const char *str, struct mls_range *r)
+{
+    int n = level_parse(str, &r->low);
+
+    if (n < 0) return -1;
+    if (str[n] == '\0') {
+        r->high = r->low;
+        return 0;
+    }
+    if (mls_level_parse(str + n + 1, &r->high) != 0) return -1;
+    return mls_dominates(&r->high, &r->low) ? 0 : -1;
+}
+
+
+int mls_dominates(const struct mls_level *a, const struct mls_level *b)
+{
+    uint64_t missing = 0;
+    int i;
+
+    if (a->sens < b->sens) return 0;
+    for (i = 0; i < MLS_CAT_WORDS; i++) {
+        missing |= b->cats[i] & ~a->cats[i];
+    }
+    return missing == 0;
+}
+
+int mls_level_eq(const struct mls_level *a, const struct mls_level *b)
+{
+    uint64_t diff = 0;
+    int i;
+
+    if (a->sens != b->sens) return 0;
+    for (i = 0; i < MLS_CAT_WORDS; i++) {
+        diff |= a->cats[i] ^ b->cats[i];
+    }
+    return diff == 0;
+}
+
+int mls_incomparable(const struct mls_level *a, const struct mls_level *b)
+{
+    return !mls_dominates(a, b) && !mls_dominates(b, a);
+}
+
+/* Read down: the subject dominates the object */
+int mls_can_read(const struct mls_level *subj, const struct mls_level *obj)
+{
+    return mls_dominates(subj, obj);
+}
+
+/* No write up or down: only at an equal level */
+int mls_can_write(const struct mls_level *subj, const struct mls_level *obj)
+{
+    return mls_level_eq(subj, obj);
+}
+
+int mls_range_contains(const struct mls_range *r, const struct mls_level *l)
+{
+    return mls_dominates(l, &r->low) && mls_dominates(&r->high, l);
+}
@@ -0,0 +1,37 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_LEVEL_H__
+#define __TEST_MLS_LEVEL_H__
+#include <stdint.h>
+
+#define MLS_CATS      1024  // c0.c1023
+#define MLS_CAT_WORDS (MLS_CATS / 64)
+
+struct mls_level {
+    int sens;
+    uint64_t cats[MLS_CAT_WORDS];
+};
+
+struct mls_range {
+    struct mls_level low;
+    struct mls_level high;
+};
+
+int mls_level_parse(const char *str, struct mls_level *l);
+int mls_range_parse(const char *str, struct mls_range *r);
+
+int mls_dominates(const struct mls_level *a, const struct mls_level *b);
+int mls_level_eq(const struct mls_level *a, const struct mls_level *b);
+int mls_incomparable(const struct mls_level *a, const struct mls_level *b);
+int mls_can_read(const struct mls_level *subj, const struct mls_level *obj);
+int mls_can_write(const struct mls_level *subj, const struct mls_level *obj);
+int mls_range_contains(const struct mls_range *r, const struct mls_level *l);
+
+#endif
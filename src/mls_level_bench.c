@@ -0,0 +1,99 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Microbenchmark of the dominance oracle: parses per second, and
+ * dominance, read and write queries per second over a pool of random
+ * levels.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "mls_level.h"
+
+#define POOL    1024        // levels to query, a power of two
+#define QUERIES 20000000
+
+static char labels[POOL][64];
+static struct mls_level pool[POOL];
+
+
+static double now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * A random level: s0..s15 and up to three category ranges
+ */
+static void random_label(char *buf, size_t len)
+{
+    int n, i, a, b;
+    size_t used;
+
+    used = snprintf(buf, len, "s%d", rand() % 16);
+    n = rand() % 4;
+    for (i = 0; i < n && used < len; i++) {
+        a = rand() % MLS_CATS;
+        b = a + rand() % 64;
+        if (b >= MLS_CATS) b = MLS_CATS - 1;
+        used += snprintf(buf + used, len - used, "%cc%d.c%d",
+                         i ? ',' : ':', a, b);
+    }
+}
+
+static void report(const char *what, unsigned long n, double secs,
+                   unsigned long hits)
+{
+    printf("%-10s %10.1f M/s  (%lu in %.3f s, %lu true)\n", what,
+           n / secs / 1e6, n, secs, hits);
+}
+
+int main(int argc, char *argv[])
+{
+    unsigned long hits;
+    unsigned long i;
+    double start;
+
+    srand(argc > 1 ? atoi(argv[1]) : 1);
+    for (i = 0; i < POOL; i++) {
+        random_label(labels[i], sizeof(labels[i]));
+    }
+
+    start = now();
+    hits = 0;
+    for (i = 0; i < QUERIES / 10; i++) {
+        hits += mls_level_parse(labels[i % POOL], &pool[i % POOL]) == 0;
+    }
+    report("parse", QUERIES / 10, now() - start, hits);
+
+    start = now();
+    hits = 0;
+    for (i = 0; i < QUERIES; i++) {
+        hits += mls_dominates(&pool[i % POOL], &pool[(i * 7 + 3) % POOL]);
+    }
+    report("dominates", QUERIES, now() - start, hits);
+
+    start = now();
+    hits = 0;
+    for (i = 0; i < QUERIES; i++) {
+        hits += mls_can_read(&pool[i % POOL], &pool[(i * 13 + 1) % POOL]);
+    }
+    report("read", QUERIES, now() - start, hits);
+
+    start = now();
+    hits = 0;
+    for (i = 0; i < QUERIES; i++) {
+        hits += mls_can_write(&pool[i % POOL], &pool[(i * 5 + 2) % POOL]);
+    }
+    report("write", QUERIES, now() - start, hits);
+    return 0;
+}
@@ -0,0 +1,718 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Test matrix generator. Each object class is described once (helper,
+ * naming, quirks); the tests are every (subject level, operation, object
+ * level) cell over the level table, with the expected outcome taken from
+ * dominance: a read is allowed when the subject dominates the object, a
+ * write only at an equal level. Every cell runs through one test function,
+ * which finds its cell from the running CUnit suite and test.
+ *
+ * In ladder mode the table is every sensitivity s0..s15 and the cells are
+ * ordered by how much they are worth: equal and adjacent levels first, then
+ * pairs with an extreme (s0 or s15), then the rest in a random order. Each
+ * class gets an equal share of a time budget; once a cell would not fit in
+ * what is left of its share, it and the cells after it are skipped. Under
+ * -j the workers draw on one share per class, through matrix_share().
+ *
+ * In pre-check mode each cell first asks the loaded policy, through the
+ * userspace AVC, and only a sample of the cells is run with helpers.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <time.h>
+#include <CUnit/CUnit.h>
+#include "mls_matrix.h"
+#include "mls_support.h"
+#include "mls_level.h"
+#include "mls_avc.h"
+#include "mls_event.h"
+#include "mls_phase.h"
+#include "mls_child.h"
+#include "mls_agent.h"
+
+#define MATRIX_MAX_CLASSES 8
+
+struct matrix_level matrix_levels[MATRIX_MAX_LEVELS] = {
+    {"low",  LVL_LOW,  "/tmp", LOW_CONTENTS},
+    {"high", LVL_HIGH, "/etc", HIGH_CONTENTS},
+};
+int matrix_nlevels = 2;
+char matrix_rings[MATRIX_MAX_LEVELS][MAX_STRING];
+struct matrix_pair matrix_pairs[MATRIX_MAX_CELLS / 2];
+int matrix_npairs = 0;
+const char *matrix_groups[MATRIX_MAX_GROUPS];
+
+static struct matrix_class *classes[MATRIX_MAX_CLASSES];
+static int nclasses = 0;
+
+static const char *op_names[] = { "read", "write" };
+
+static int ladder_budget = 0;   // seconds for the whole run, 0 = no ladder
+static char ladder_names[MATRIX_MAX_LEVELS][8];
+
+
+/*
+ * Expected outcome of op by a subject at level subj on an object at obj,
+ * from the dominance oracle
+ */
+enum matrix_expect matrix_expect(const struct matrix_class *c,
+                                 enum matrix_op op, int subj, int obj)
+{
+    struct mls_level s, o;
+
+    if (mls_level_parse(matrix_levels[subj].lvl, &s) != 0 ||
+        mls_level_parse(matrix_levels[obj].lvl, &o) != 0) {
+        fprintf(stderr, "cannot parse level '%s' or '%s'\n",
+                matrix_levels[subj].lvl, matrix_levels[obj].lvl);
+        return EXPECT_ANY;
+    }
+    if (op == OP_READ) {
+        return mls_can_read(&s, &o) ? EXPECT_ALLOW : EXPECT_DENY;
+    }
+    if (mls_can_write(&s, &o)) {
+        return EXPECT_ALLOW;
+    }
+    if (mls_dominates(&o, &s)) {
+        return c->write_up;
+    }
+    return EXPECT_DENY;
+}
+
+
+/*
+ * The command line of a helper step at level at; num holds the test
+ */
+static void matrix_argv(char *argv[12], char num[16],
+                        const struct matrix_class *c, int at, int test,
+                        const char *obj, const char *data)
+{
+    int n = 0;
+
+    snprintf(num, 16, "%d", test);
+    argv[n++] = (char *)c->helper;
+    argv[n++] = "--test";
+    argv[n++] = num;
+    argv[n++] = "--events";
+    argv[n++] = matrix_rings[at];
+    argv[n++] = "--file";
+    argv[n++] = (char *)obj;
+    if (data != NULL) {
+        argv[n++] = "--data";
+        argv[n++] = (char *)data;
+    }
+    if (c->system_v) {
+        argv[n++] = "--sysv";
+    }
+    argv[n] = NULL;
+}
+
+/*
+ * Run one helper step at level at
+ */
+static void matrix_step(const struct matrix_class *c, int at, int test,
+                        const char *obj, const char *data, const char *what)
+{
+    char num[16];
+    char *argv[12];
+
+    matrix_argv(argv, num, c, at, test, obj, data);
+    fprintf(stderr, "%s\n", what);
+    fork_to_lvl(matrix_levels[at].lvl, argv);
+}
+
+/*
+ * An allowed read where the reader is waiting before anything is written:
+ * the owner creates the object unwritten, the reader is started and
+ * attaches, and only then does the owner write. The reader times the
+ * handoff from the write to its wakeup.
+ */
+static void matrix_handoff(const struct matrix_class *c,
+                           const struct matrix_cell *cell, const char *obj,
+                           const char *data)
+{
+    struct mls_child reader;
+    char num[16];
+    char *argv[12];
+
+    matrix_step(c, cell->obj, 6, obj, NULL, "Creating, not writing");
+    matrix_argv(argv, num, c, cell->subj, 2, obj, data);
+    fprintf(stderr, "Attaching and reading, before the write\n");
+    if (child_launch(&reader, matrix_levels[cell->subj].lvl, argv) != 0) {
+        CU_FAIL("launch failed");
+        return;
+    }
+    if (!event_wait(reader.pid, "attach_shm", WAIT_DEADLINE_MS)) {
+        CU_FAIL("reader did not attach");
+    }
+    matrix_step(c, cell->obj, 3, obj, data, "Attaching and writing");
+    child_wait(&reader);
+    child_exit_ok(&reader);
+}
+
+/*
+ * An IPC object lives for one test: its owner creates it at the object
+ * level, the subject tries op on it, and the owner destroys it
+ */
+static void matrix_run_ipc(const struct matrix_class *c,
+                           const struct matrix_cell *cell)
+{
+    const char *obj = c->objects[cell->obj];
+    const char *data = matrix_levels[cell->obj].data;
+    char num[16];
+
+    if (c->numeric_data) {
+        snprintf(num, sizeof(num), "%d", rand() % 100);
+        data = num;
+    }
+
+    if (cell->op == OP_READ && c->handoff && !agent_mode &&
+        cell->expect != EXPECT_DENY) {
+        matrix_handoff(c, cell, obj, data);
+    } else if (cell->op == OP_READ) {
+        matrix_step(c, cell->obj, 1, obj, data, "Creating and writing");
+        if (cell->expect == EXPECT_DENY) {
+            matrix_step(c, cell->subj, 4, obj, NULL,
+                        "Attaching to read, expecting failure");
+        } else {
+            matrix_step(c, cell->subj, 2, obj, data, "Attaching and reading");
+        }
+    } else {
+        matrix_step(c, cell->obj, 1, obj, c->blank, "Creating");
+        if (cell->expect == EXPECT_DENY) {
+            matrix_step(c, cell->subj, 5, obj, NULL,
+                        "Attaching to write, expecting failure");
+        } else {
+            matrix_step(c, cell->subj, 3, obj, data, "Attaching and writing");
+            matrix_step(c, cell->obj, 2, obj, data, "Reading back");
+        }
+    }
+    matrix_step(c, cell->obj, 0, obj, NULL, "Destroying");
+}
+
+/*
+ * Files are fixtures made by the runner at init; one helper step each
+ */
+static void matrix_run_file(const struct matrix_class *c,
+                            const struct matrix_cell *cell)
+{
+    int test;
+
+    if (cell->op == OP_READ) {
+        test = (cell->expect == EXPECT_ALLOW) ? 5 : 6;
+        matrix_step(c, cell->subj, test, c->objects[cell->obj],
+                    matrix_levels[cell->obj].data, "Reading file");
+    } else {
+        test = (cell->expect == EXPECT_ALLOW) ? 7 :
+               (cell->expect == EXPECT_DENY) ? 8 : 9;
+        matrix_step(c, cell->subj, test, c->targets[cell->obj], NULL,
+                    "Writing file");
+    }
+}
+
+/*
+ * Add to a sum other workers may be adding to
+ */
+static void add_secs(double *sum, double secs)
+{
+    double old, new;
+
+    __atomic_load(sum, &old, __ATOMIC_RELAXED);
+    do {
+        new = old + secs;
+    } while (!__atomic_compare_exchange(sum, &old, &new, 0, __ATOMIC_RELAXED,
+                                        __ATOMIC_RELAXED));
+}
+
+/*
+ * Run the helpers of a cell and time them
+ */
+static void matrix_check(struct matrix_class *c,
+                         const struct matrix_cell *cell,
+                         struct matrix_outcome *out)
+{
+    struct timespec start, end;
+
+    phase_cell(c->suite, matrix_levels[cell->subj].name,
+               matrix_levels[cell->obj].name);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    if (c->naming == NAME_FILE) {
+        matrix_run_file(c, cell);
+    } else {
+        matrix_run_ipc(c, cell);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    out->secs = (end.tv_sec - start.tv_sec) +
+                (end.tv_nsec - start.tv_nsec) / 1e9;
+    add_secs(&c->tally->spent, out->secs);
+    __sync_fetch_and_add(&c->tally->checked, 1);
+    out->ran = 1;
+    event_drain();
+    phase_cell(NULL, NULL, NULL);
+}
+
+/*
+ * Ask the policy for the cell's decision and hold it to the model; for a
+ * sample of the cells, run the helpers expecting what the policy said.
+ * SysV objects carry their creator's label; files and POSIX segments the
+ * file context of their level.
+ */
+static void matrix_precheck(struct matrix_class *c,
+                            const struct matrix_cell *cell,
+                            struct matrix_outcome *out)
+{
+    const struct level_context *subj, *obj;
+    struct matrix_cell confirm;
+    struct timespec start, end;
+    unsigned int failures;
+
+    subj = level_context(matrix_levels[cell->subj].lvl);
+    obj = level_context(matrix_levels[cell->obj].lvl);
+    if (subj == NULL || obj == NULL) {
+        CU_FAIL("no context for the cell's levels");
+        return;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    out->policy = avc_decide(subj->proc,
+                             (c->naming == NAME_KEY) ? obj->proc : obj->file,
+                             c->tclass, op_names[cell->op]);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    add_secs(&c->tally->asked, (end.tv_sec - start.tv_sec) +
+                               (end.tv_nsec - start.tv_nsec) / 1e9);
+    __sync_fetch_and_add(&c->tally->queried, 1);
+    if (out->policy < 0) {
+        CU_FAIL("policy could not be asked");
+        return;
+    }
+    if (cell->expect != EXPECT_ANY) {
+        CU_ASSERT_EQUAL(out->policy, cell->expect == EXPECT_ALLOW);
+    }
+
+    if (rand() % 100 >= avc_confirm) return;
+    confirm = *cell;
+    confirm.expect = out->policy ? EXPECT_ALLOW : EXPECT_DENY;
+    failures = CU_get_number_of_failures();
+    matrix_check(c, &confirm, out);
+    out->confirmed = 1;
+    out->disagree = (CU_get_number_of_failures() != failures);
+}
+
+/*
+ * The test function of every generated test
+ */
+static void matrix_run(void)
+{
+    CU_pSuite suite = CU_get_current_suite();
+    CU_pTest test = CU_get_current_test();
+    struct matrix_class *c;
+    struct matrix_cell *cell;
+    struct matrix_tally *t;
+    double share;
+    int i, j;
+
+    for (i = 0; i < nclasses; i++) {
+        c = classes[i];
+        if (strcmp(c->suite, suite->pName) != 0) continue;
+        for (j = 0; j < c->ncells; j++) {
+            cell = &c->cells[j];
+            if (strcmp(cell->name, test->pName) != 0) continue;
+
+            t = c->tally;
+            if (avc_confirm >= 0) {
+                matrix_precheck(c, cell, &t->cells[j]);
+                return;
+            }
+
+            // skip once the average cell no longer fits in the share
+            share = (double)ladder_budget / nclasses;
+            if (ladder_budget > 0 && t->checked > 0 &&
+                t->spent + t->spent / t->checked > share) {
+                fprintf(stderr, "%s: out of time, skipped\n", cell->name);
+                __sync_fetch_and_add(&t->skipped, 1);
+                return;
+            }
+            matrix_check(c, cell, &t->cells[j]);
+            return;
+        }
+    }
+    CU_FAIL("no matrix cell for this test");
+}
+
+static void add_cell(struct matrix_class *c, int s, int o, int op,
+                     int group)
+{
+    struct matrix_cell *cell = &c->cells[c->ncells];
+
+    if (c->ncells == MATRIX_MAX_CELLS) {
+        fprintf(stderr, "%s: too many cells\n", c->suite);
+        return;
+    }
+    cell->subj = s;
+    cell->obj = o;
+    cell->op = op;
+    cell->expect = matrix_expect(c, op, s, o);
+    cell->group = group;
+    memset(&c->tally->cells[c->ncells], 0, sizeof(struct matrix_outcome));
+    c->tally->cells[c->ncells].policy = -1;
+    snprintf(cell->name, sizeof(cell->name), "%s%s_%s_%s",
+             c->prefix, matrix_levels[s].name, op_names[op],
+             matrix_levels[o].name);
+    c->tests[c->ncells].pName = cell->name;
+    c->tests[c->ncells].pTestFunc = matrix_run;
+    c->ncells++;
+}
+
+
+/*
+ * How much a (subject, object) pair of the ladder is worth checking
+ */
+static int ladder_tier(int s, int o)
+{
+    if (abs(s - o) <= 1) return 0;              // equal or adjacent
+    if (s == 0 || o == 0 || s == LADDER_TOP || o == LADDER_TOP) return 1;
+    return 2;
+}
+
+/*
+ * All pairs, as s * matrix_nlevels + o, best first. The random order of
+ * the last tier is fixed once per run, so every class samples the same
+ * pairs.
+ */
+static void ladder_order(int *order, int *npairs)
+{
+    static unsigned int seed = 0;
+    int tier, s, o, i, j, t, first;
+    int n = 0;
+
+    if (seed == 0) {
+        seed = (unsigned int)time(NULL);
+        fprintf(stderr, "ladder: sampling with seed %u\n", seed);
+    }
+    for (tier = 0; tier <= 2; tier++) {
+        first = n;
+        for (s = 0; s < matrix_nlevels; s++) {
+            for (o = 0; o < matrix_nlevels; o++) {
+                if (ladder_tier(s, o) == tier) {
+                    order[n++] = s * matrix_nlevels + o;
+                }
+            }
+        }
+        if (tier == 2) {
+            srand(seed);
+            for (i = n - 1; i > first; i--) {
+                j = first + rand() % (i - first + 1);
+                t = order[i];
+                order[i] = order[j];
+                order[j] = t;
+            }
+        }
+    }
+    *npairs = n;
+}
+
+
+/*
+ * Build the level table by hand: the first call replaces the default
+ * table. Must be called before any suite is generated.
+ *
+ * Returns the index of the level, or -1 if the table is full
+ */
+int matrix_add_level(const char *name, const char *lvl, const char *data)
+{
+    static int replaced = 0;
+    struct matrix_level *l;
+
+    if (!replaced) {
+        matrix_nlevels = 0;
+        replaced = 1;
+    }
+    if (matrix_nlevels == MATRIX_MAX_LEVELS) {
+        fprintf(stderr, "too many levels, '%s' not added\n", lvl);
+        return -1;
+    }
+    l = &matrix_levels[matrix_nlevels];
+    l->name = name;
+    l->lvl = lvl;
+    l->key_path = NULL;
+    l->data = data;
+    return matrix_nlevels++;
+}
+
+/*
+ * Generate cells for this pair only, rather than for every pair of levels
+ *
+ * Returns 0, or -1 if there are too many pairs
+ */
+int matrix_add_pair(int subj, int obj, int group)
+{
+    if (matrix_npairs == MATRIX_MAX_CELLS / 2) return -1;
+    matrix_pairs[matrix_npairs].subj = subj;
+    matrix_pairs[matrix_npairs].obj = obj;
+    matrix_pairs[matrix_npairs].group = group;
+    matrix_npairs++;
+    return 0;
+}
+
+
+/*
+ * Switch to the s0..s15 ladder, to be covered in about budget seconds.
+ * Must be called before any suite is generated.
+ */
+void matrix_ladder(int budget)
+{
+    int i;
+
+    ladder_budget = budget;
+    matrix_nlevels = LADDER_TOP + 1;
+    for (i = 0; i < matrix_nlevels; i++) {
+        snprintf(ladder_names[i], sizeof(ladder_names[i]), "s%d", i);
+        matrix_levels[i].name = ladder_names[i];
+        matrix_levels[i].lvl = ladder_names[i];
+        matrix_levels[i].key_path = NULL;
+        matrix_levels[i].data = ladder_names[i];
+    }
+}
+
+
+/*
+ * Mean time of a class's cells, per group
+ */
+static void group_report(const struct matrix_class *c)
+{
+    double secs[MATRIX_MAX_GROUPS] = { 0 };
+    unsigned int n[MATRIX_MAX_GROUPS] = { 0 };
+    const struct matrix_cell *cell;
+    const struct matrix_outcome *out;
+    int i;
+
+    for (i = 0; i < c->ncells; i++) {
+        cell = &c->cells[i];
+        out = &c->tally->cells[i];
+        if (!out->ran || cell->group < 0) continue;
+        secs[cell->group] += out->secs;
+        n[cell->group]++;
+    }
+    for (i = 0; i < MATRIX_MAX_GROUPS; i++) {
+        if (n[i] == 0) continue;
+        fprintf(stderr, "  %-12s %3u cells, %8.3f ms per cell\n",
+                matrix_groups[i] ? matrix_groups[i] : "?", n[i],
+                secs[i] * 1000 / n[i]);
+    }
+}
+
+/*
+ * Policy pre-check: what asking cost against confirming, and every cell
+ * where the policy differs from the model or the kernel from the policy
+ */
+static void precheck_report(const struct matrix_class *c)
+{
+    const struct matrix_tally *t = c->tally;
+    const struct matrix_cell *cell;
+    const struct matrix_outcome *out;
+    int i;
+
+    fprintf(stderr, "  policy asked %u times, %8.3f ms per cell; "
+            "%u confirmed, %8.3f ms per cell\n", t->queried,
+            t->asked * 1000 / t->queried, t->checked,
+            t->checked ? t->spent * 1000 / t->checked : 0.0);
+    for (i = 0; i < c->ncells; i++) {
+        cell = &c->cells[i];
+        out = &t->cells[i];
+        if (out->policy >= 0 && cell->expect != EXPECT_ANY &&
+            out->policy != (cell->expect == EXPECT_ALLOW)) {
+            fprintf(stderr, "  %s: policy %s, model %s\n", cell->name,
+                    out->policy ? "allows" : "denies",
+                    cell->expect == EXPECT_ALLOW ? "allows" : "denies");
+        }
+        if (out->disagree) {
+            fprintf(stderr, "  %s: policy %s, kernel did not\n", cell->name,
+                    out->policy ? "allows" : "denies");
+        }
+    }
+}
+
+/*
+ * Per class: time spent, cells checked and skipped, the mean time per
+ * group of cells, and in ladder mode a map of the pairs checked (subject
+ * down, object across; R read, W write, B both)
+ */
+void matrix_report(void)
+{
+    const struct matrix_class *c;
+    const struct matrix_cell *cell;
+    const struct matrix_tally *t;
+    char grid[LADDER_TOP + 1][LADDER_TOP + 1];
+    char mark, *g;
+    int i, j, s;
+
+    for (i = 0; i < nclasses; i++) {
+        c = classes[i];
+        t = c->tally;
+        if (t->checked + t->skipped + t->queried == 0) continue;
+        fprintf(stderr, "%-10s: %6.2f s, %u cells checked, %u skipped\n",
+                c->suite, t->spent, t->checked, t->skipped);
+        group_report(c);
+        if (t->queried > 0) precheck_report(c);
+        if (ladder_budget == 0 || matrix_npairs > 0) continue;
+
+        memset(grid, '.', sizeof(grid));
+        for (j = 0; j < c->ncells; j++) {
+            cell = &c->cells[j];
+            if (!t->cells[j].ran) continue;
+            g = &grid[cell->subj][cell->obj];
+            mark = (cell->op == OP_READ) ? 'R' : 'W';
+            *g = (*g == '.' || *g == mark) ? mark : 'B';
+        }
+        for (s = 0; s < matrix_nlevels; s++) {
+            fprintf(stderr, "  %4s  %.*s\n", matrix_levels[s].name,
+                    matrix_nlevels, grid[s]);
+        }
+    }
+}
+
+
+/*
+ * Room for the tallies of every class, for matrix_share()
+ */
+size_t matrix_share_size(void)
+{
+    return nclasses * sizeof(struct matrix_tally);
+}
+
+/*
+ * Move the tallies into mem, matrix_share_size() bytes the workers will
+ * share; the budget then counts every worker's cells, and the parent can
+ * report them all once the workers are done
+ */
+void matrix_share(void *mem)
+{
+    struct matrix_tally *t = mem;
+    int i;
+
+    for (i = 0; i < nclasses; i++) {
+        t[i] = *classes[i]->tally;
+        classes[i]->tally = &t[i];
+    }
+}
+
+
+/*
+ * Generate the tests of a class over the current level table
+ */
+CU_SuiteInfo matrix_suite(struct matrix_class *c, CU_InitializeFunc init,
+                          CU_CleanupFunc cleanup)
+{
+    CU_SuiteInfo info = {
+        .pName = c->suite, .pInitFunc = init, .pCleanupFunc = cleanup,
+        .pTests = c->tests
+    };
+    int order[(LADDER_TOP + 1) * (LADDER_TOP + 1)];
+    int npairs;
+    int s, o, op;
+    int i;
+
+    if (nclasses < MATRIX_MAX_CLASSES) {
+        classes[nclasses++] = c;
+    }
+
+    c->tally = &c->own_tally;
+    memset(c->tally, 0, sizeof(*c->tally));
+    c->ncells = 0;
+    if (matrix_npairs > 0) {
+        for (i = 0; i < matrix_npairs; i++) {
+            for (op = OP_READ; op <= OP_WRITE; op++) {
+                add_cell(c, matrix_pairs[i].subj, matrix_pairs[i].obj, op,
+                         matrix_pairs[i].group);
+            }
+        }
+    } else if (ladder_budget > 0) {
+        ladder_order(order, &npairs);
+        for (i = 0; i < npairs; i++) {
+            for (op = OP_READ; op <= OP_WRITE; op++) {
+                add_cell(c, order[i] / matrix_nlevels,
+                         order[i] % matrix_nlevels, op, -1);
+            }
+        }
+    } else {
+        for (s = 0; s < matrix_nlevels; s++) {
+            for (op = OP_READ; op <= OP_WRITE; op++) {
+                for (o = 0; o < matrix_nlevels; o++) {
+                    add_cell(c, s, o, op, -1);
+                }
+            }
+        }
+    }
+    c->tests[c->ncells].pName = NULL;
+    c->tests[c->ncells].pTestFunc = NULL;
+    return info;
+}
+
+
+/*
+ * Suite setup: per-level event rings, object names and, for files, the
+ * fixtures
+ */
+int matrix_class_init(struct matrix_class *c)
+{
+    const struct matrix_level *l;
+    char name[MAX_STRING];
+    int i;
+
+    worker_name(name, sizeof(name), "log/events.bin");
+    if (event_output(name) != 0) return -1;
+    event_hook = phase_event;
+
+    for (i = 0; i < matrix_nlevels; i++) {
+        l = &matrix_levels[i];
+
+        snprintf(name, sizeof(name), "log/%s_events.ring", l->name);
+        worker_name(matrix_rings[i], sizeof(matrix_rings[i]), name);
+        if (create_ring(l->lvl, matrix_rings[i]) != 0 ||
+            event_attach(matrix_rings[i]) != 0) {
+            return -1;
+        }
+
+        switch (c->naming) {
+            case NAME_POSIX:
+                snprintf(name, sizeof(name), "/%s_object", l->name);
+                worker_name(c->objects[i], sizeof(c->objects[i]), name);
+                break;
+            case NAME_KEY:
+                if (l->key_path != NULL) {
+                    snprintf(name, sizeof(name), "%s", l->key_path);
+                } else {
+                    // any file processes at every level can stat will do
+                    snprintf(name, sizeof(name), "files/ftok.%s", l->name);
+                    if (create_file(LVL_SYSLOW, name, NULL) != 0) {
+                        return -1;
+                    }
+                }
+                if (!worker_key_path(c->objects[i], sizeof(c->objects[i]),
+                                     name)) {
+                    return -1;
+                }
+                break;
+            case NAME_FILE:
+                snprintf(name, sizeof(name), "files/read_%s.txt", l->name);
+                worker_name(c->objects[i], sizeof(c->objects[i]), name);
+                snprintf(name, sizeof(name), "files/write_%s.txt", l->name);
+                worker_name(c->targets[i], sizeof(c->targets[i]), name);
+                unlink(c->objects[i]);
+                if (create_file(l->lvl, c->objects[i], l->data) != 0 ||
+                    create_file(l->lvl, c->targets[i], NULL) != 0) {
+                    return -1;
+                }
+                break;
+        }
+    }
+    return 0;
+}
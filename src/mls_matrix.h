@@ -0,0 +1,117 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_MATRIX_H__
+#define __TEST_MLS_MATRIX_H__
+#include <CUnit/CUnit.h>
+#include "mls_support.h"
+#include "mls_level.h"
+
+#define MATRIX_MAX_LEVELS 64
+#define MATRIX_MAX_CELLS  512
+#define MATRIX_MAX_GROUPS 8
+#define LADDER_TOP        15    // the ladder is s0..s15
+
+enum matrix_op { OP_READ, OP_WRITE };
+enum matrix_expect { EXPECT_ALLOW, EXPECT_DENY, EXPECT_ANY };
+
+/* How a class names the object it keeps at each level */
+enum matrix_naming {
+    NAME_POSIX,         // a POSIX IPC name, /<level>_object
+    NAME_KEY,           // a path handed to ftok() for a System V object
+    NAME_FILE           // fixture files made by the runner, read_/write_<level>
+};
+
+struct matrix_level {
+    const char *name;           // used in test names: low, high
+    const char *lvl;            // s0, s15
+    const char *key_path;       // ftok() path, or NULL for an anchor file
+    const char *data;           // what objects at this level hold
+};
+
+struct matrix_cell {
+    char name[MAX_STRING];      // test_low_read_high
+    int subj;                   // level of the process doing op
+    int obj;                    // level of the object
+    enum matrix_op op;
+    enum matrix_expect expect;
+    int group;                  // for the timing report, or -1
+};
+
+/* What came of a cell; written by whichever worker ran it */
+struct matrix_outcome {
+    int ran;                    // checked, rather than skipped for time
+    double secs;                // time the cell took
+    int policy;                 // policy pre-check: 1 allow, 0 deny, -1 not asked
+    int confirmed;              // the pre-check was confirmed by helpers
+    int disagree;               // ... and the kernel did otherwise
+};
+
+/*
+ * A class's counters and outcomes. Under -j they live in the scheduler's
+ * shared mapping, so the budget and the report cover every worker.
+ */
+struct matrix_tally {
+    double spent;               // seconds spent running cells
+    unsigned int checked;
+    unsigned int skipped;
+    double asked;               // seconds spent asking the policy
+    unsigned int queried;
+    struct matrix_outcome cells[MATRIX_MAX_CELLS];
+};
+
+/* An explicit (subject, object) pair, instead of every pair of levels */
+struct matrix_pair {
+    int subj;
+    int obj;
+    int group;
+};
+
+struct matrix_class {
+    const char *suite;          // CUnit suite name
+    const char *helper;         // helper binary
+    const char *prefix;         // test name prefix: test_, test_v_
+    enum matrix_naming naming;
+    int system_v;               // pass --sysv to the helper
+    int numeric_data;           // data must be a number (semaphores)
+    const char *blank;          // data to create a write target with, or NULL
+    enum matrix_expect write_up;    // writing to a dominating level
+    int handoff;                // allowed reads wait for the write (test 6)
+    const char *tclass;         // policy class of the object, for the pre-check
+
+    // filled in by matrix_suite() and matrix_class_init()
+    char objects[MATRIX_MAX_LEVELS][MAX_STRING];
+    char targets[MATRIX_MAX_LEVELS][MAX_STRING];  // write targets for files
+    int ncells;
+    struct matrix_cell cells[MATRIX_MAX_CELLS];
+    CU_TestInfo tests[MATRIX_MAX_CELLS + 1];
+    struct matrix_tally *tally; // own_tally, or shared by matrix_share()
+    struct matrix_tally own_tally;
+};
+
+extern struct matrix_level matrix_levels[MATRIX_MAX_LEVELS];
+extern int matrix_nlevels;
+extern char matrix_rings[MATRIX_MAX_LEVELS][MAX_STRING];
+extern struct matrix_pair matrix_pairs[MATRIX_MAX_CELLS / 2];
+extern int matrix_npairs;
+extern const char *matrix_groups[MATRIX_MAX_GROUPS];
+
+enum matrix_expect matrix_expect(const struct matrix_class *c,
+                                 enum matrix_op op, int subj, int obj);
+CU_SuiteInfo matrix_suite(struct matrix_class *c, CU_InitializeFunc init,
+                          CU_CleanupFunc cleanup);
+int matrix_class_init(struct matrix_class *c);
+int matrix_add_level(const char *name, const char *lvl, const char *data);
+int matrix_add_pair(int subj, int obj, int group);
+void matrix_ladder(int budget);
+size_t matrix_share_size(void);
+void matrix_share(void *mem);
+void matrix_report(void);
+
+#endif
@@ -10,10 +10,11 @@
 #ifndef __TEST_MLS_MSG_H__
 #define __TEST_MLS_MSG_H__
 #include <CUnit/CUnit.h>
+#include "mls_matrix.h"
 
 int test_msg_init(void);
 int test_msg_cleanup(void);
-extern CU_TestInfo msg_tests[];
+extern struct matrix_class msg_class;
 
 #endif
 
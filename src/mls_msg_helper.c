@@ -11,7 +11,6 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
-#include <getopt.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
@@ -19,14 +18,16 @@
 #include <fcntl.h>     // for the O_ constants
 #include <sys/ipc.h>
 #include <sys/msg.h>
-#include <selinux/selinux.h>
-#include <selinux/context.h> // for context-mangling functions
 #include "mls_msg.h"
 #include "mls_support.h"
+#include "mls_helper.h"
+#include "mls_wait.h"
+#include "mls_event.h"
 
 
 int create_msgq(const char *path, int fail)
 {
+    EVENT_PHASE();
     int status = 0;
     key_t key;
     int id = -1;
@@ -55,8 +56,10 @@ int create_msgq(const char *path, int fail)
 
 int attach_msgq(int oflag, const char *path, int fail)
 {
+    EVENT_PHASE();
     int status = 0;
-    int i = 0;
+    struct deadline dl;
+    int err;
     int id = -1;
     char *smode = (oflag == O_RDONLY) ? "read" : "write";
     int mode = (oflag == O_RDONLY) ? MODE_R : MODE_W;
@@ -70,15 +73,12 @@ int attach_msgq(int oflag, const char *path, int fail)
         exit(-1);
     }
 
-    while ((i < MAX_TRIES) && (id < 0)) {
-        id = msgget(key, mode);
-        i++;
-
-        if (id < 0) {
-            perror("msgget failed");
-            printf("Waiting %d seconds to try again.\n", WAIT_TIME);
-            sleep(WAIT_TIME);
-        }
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    while ((id = msgget(key, mode)) < 0) {
+        err = errno;
+        perror("msgget failed");
+        // only a missing object is worth waiting for
+        if (err != ENOENT || !wait_retry(&dl)) break;
     }
 
     if (id < 0) {
@@ -95,6 +95,7 @@ int attach_msgq(int oflag, const char *path, int fail)
 
 int close_msgq(const char *path, int fail)
 {
+    EVENT_PHASE();
     int status = 0;
     key_t key;
     int id = -1;
@@ -133,6 +134,7 @@ int close_msgq(const char *path, int fail)
 
 int write_msg(int id, const char* data, int fail)
 {
+    EVENT_PHASE();
     int status = -1;
     struct shared_space_t buffer;
 
@@ -159,6 +161,7 @@ int write_msg(int id, const char* data, int fail)
 
 int read_msg(int id, const char* data, int fail)
 {
+    EVENT_PHASE();
     int status = -1;
     struct shared_space_t buffer;
 
@@ -187,87 +190,16 @@ int read_msg(int id, const char* data, int fail)
 
 
 /*****************************************************************************
- * Main
+ * Driver
  */
 
-int main(int argc, char* argv[])
+int msg_helper(const struct helper_args *args)
 {
-    context_t ctx = NULL;
-    security_context_t ctx_check = NULL;
-    int opt, option_index;
-    int test_num = -1;
-    int level = -1;
     int fd = -1;
-    char *path = NULL;
-    char *log_path = NULL;
-    char *data = NULL;
-    time_t t;
-
-    static struct option long_options[] = {
-      {"output",  required_argument, 0, 'o'},
-      {"test",    required_argument, 0, 't'},
-      {"file",    required_argument, 0, 'f'},
-      {"data",    required_argument, 0, 'd'},
-      {0, 0, 0, 0}
-    };
-
-    while ((opt = getopt_long(argc, argv, "o:t:f:d:",
-                              long_options, &option_index)) != -1)
-    {
-        switch (opt) {            
-            case 'o':
-                log_path = optarg;
-                if (freopen(log_path, "a+", stdout) == NULL) {
-                    exit(-1);
-                }
-                if (freopen(log_path, "a+", stderr) == NULL) {
-                    exit(-1);
-                }
-                break;
-            case 't':
-                test_num = atoi(optarg);
-                break;
-            case 'f':
-                path = optarg;
-                break;
-            case 'd':
-                data = optarg;
-                break;
-            default:
-                printf("bad argument.\n");
-                exit(-1);
-            }
-    }     
-
-    if (test_num == -1) {
-        printf("no test specified.\n");
-        exit(-1);
-    } else if (path == NULL) {
-        printf("no path specified.\n");
-        exit(-1);
-    }
+    char *path = args->path;
+    char *data = args->data;
 
-    time(&t);
-    printf("\n%s", ctime(&t));
-    getcon(&ctx_check);
-    printf("Context: '%s'\n", ctx_check); 
-    ctx = context_new(ctx_check);
-    const char *range = context_range_get(ctx);
-
-    if (strncmp(LVL_HIGH"-", range, sizeof(LVL_HIGH"-")-1) == 0) {
-        level = AT_HIGH;
-        printf("process is at high\n");
-    } else if (strncmp(LVL_LOW"-", range, sizeof(LVL_LOW"-")-1) == 0) {
-        level = AT_LOW;
-        printf("process is at low\n");
-    } else {
-        printf("unexpected level\n");
-        exit(-1);
-    }
-
-    fflush(stdout); fflush(stderr);
-
-    switch(test_num) {
+    switch(args->test_num) {
         case 0: 
             printf("deleting msgq\n");
             close_msgq(path, 0);
@@ -302,4 +234,3 @@ int main(int argc, char* argv[])
     }
     return 0;
 }
-
@@ -0,0 +1,135 @@
+/* 
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Checks of the dominance oracle itself; every expected outcome in the
+ * other suites comes from it.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <CUnit/CUnit.h>
+#include "mls_oracle.h"
+#include "mls_level.h"
+
+int test_oracle_init(void)
+{
+    return 0;
+}
+
+int test_oracle_cleanup(void)
+{
+    return 0;
+}
+
+static int dom(const char *a, const char *b)
+{
+    struct mls_level la, lb;
+
+    if (mls_level_parse(a, &la) != 0 || mls_level_parse(b, &lb) != 0) {
+        CU_FAIL("level did not parse");
+        return -1;
+    }
+    return mls_dominates(&la, &lb);
+}
+
+
+/*****************************************************************************
+ * Oracle tests
+ */
+
+static void test_parse(void)
+{
+    struct mls_level l;
+    struct mls_range r;
+
+    CU_ASSERT_EQUAL(mls_level_parse("s0", &l), 0);
+    CU_ASSERT_EQUAL(mls_level_parse("s15:c0.c1023", &l), 0);
+    CU_ASSERT_EQUAL(l.sens, 15);
+    CU_ASSERT_EQUAL(l.cats[0], ~(uint64_t)0);
+    CU_ASSERT_EQUAL(l.cats[MLS_CAT_WORDS - 1], ~(uint64_t)0);
+    CU_ASSERT_EQUAL(mls_level_parse("s5:c1,c7,c64.c65", &l), 0);
+    CU_ASSERT_EQUAL(l.cats[0], ((uint64_t)1 << 1) | ((uint64_t)1 << 7));
+    CU_ASSERT_EQUAL(l.cats[1], 3);
+
+    CU_ASSERT_NOT_EQUAL(mls_level_parse("", &l), 0);
+    CU_ASSERT_NOT_EQUAL(mls_level_parse("c1", &l), 0);
+    CU_ASSERT_NOT_EQUAL(mls_level_parse("s5:", &l), 0);
+    CU_ASSERT_NOT_EQUAL(mls_level_parse("s5:c1024", &l), 0);
+    CU_ASSERT_NOT_EQUAL(mls_level_parse("s5:c7.c1", &l), 0);
+    CU_ASSERT_NOT_EQUAL(mls_level_parse("s0-s15", &l), 0);
+
+    CU_ASSERT_EQUAL(mls_range_parse("s0-s15:c0.c1023", &r), 0);
+    CU_ASSERT_EQUAL(mls_range_parse("s3", &r), 0);
+    CU_ASSERT_NOT_EQUAL(mls_range_parse("s15-s0", &r), 0);
+    CU_ASSERT_NOT_EQUAL(mls_range_parse("s5:c1-s5:c2", &r), 0);
+}
+
+static void test_dominance(void)
+{
+    struct mls_level a, b;
+
+    CU_ASSERT_EQUAL(dom("s15", "s0"), 1);
+    CU_ASSERT_EQUAL(dom("s0", "s15"), 0);
+    CU_ASSERT_EQUAL(dom("s5:c1,c7", "s5:c7"), 1);
+    CU_ASSERT_EQUAL(dom("s5:c7", "s5:c1,c7"), 0);
+    CU_ASSERT_EQUAL(dom("s15", "s0:c3"), 0);
+    CU_ASSERT_EQUAL(dom("s0:c0.c1023", "s0:c1023"), 1);
+
+    mls_level_parse("s5:c1,c7", &a);
+    mls_level_parse("s5:c2", &b);
+    CU_ASSERT_TRUE(mls_incomparable(&a, &b));
+    mls_level_parse("s5:c1", &b);
+    CU_ASSERT_FALSE(mls_incomparable(&a, &b));
+}
+
+static void test_read_write(void)
+{
+    struct mls_level low, high, cat;
+
+    mls_level_parse("s0", &low);
+    mls_level_parse("s15", &high);
+    mls_level_parse("s15:c4", &cat);
+
+    CU_ASSERT_TRUE(mls_can_read(&high, &low));
+    CU_ASSERT_FALSE(mls_can_read(&low, &high));
+    CU_ASSERT_FALSE(mls_can_read(&high, &cat));
+    CU_ASSERT_TRUE(mls_can_read(&cat, &high));
+    CU_ASSERT_TRUE(mls_can_write(&low, &low));
+    CU_ASSERT_FALSE(mls_can_write(&low, &high));
+    CU_ASSERT_FALSE(mls_can_write(&high, &low));
+    CU_ASSERT_FALSE(mls_can_write(&cat, &high));
+}
+
+static void test_range(void)
+{
+    struct mls_range r;
+    struct mls_level l;
+
+    mls_range_parse("s2:c1-s9:c0.c10", &r);
+    mls_level_parse("s5:c1,c4", &l);
+    CU_ASSERT_TRUE(mls_range_contains(&r, &l));
+    mls_level_parse("s5:c4", &l);
+    CU_ASSERT_FALSE(mls_range_contains(&r, &l));
+    mls_level_parse("s10:c1", &l);
+    CU_ASSERT_FALSE(mls_range_contains(&r, &l));
+    mls_level_parse("s9:c0.c10", &l);
+    CU_ASSERT_TRUE(mls_range_contains(&r, &l));
+}
+
+
+/*****************************************************************************
+ * test structure
+ */
+
+CU_TestInfo oracle_tests[] = {
+    {"test_parse", test_parse},
+    {"test_dominance", test_dominance},
+    {"test_read_write", test_read_write},
+    {"test_range", test_range},
+    CU_TEST_INFO_NULL
+};
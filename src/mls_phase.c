@@ -0,0 +1,294 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Per-phase latency. Every step of a cell is split into phases: the
+ * runner times the launch (fork or posix_spawn) itself; exec is from the
+ * launch returning to the helper's main(), which covers the level change,
+ * execvp and the loader; init is from main() to the helper's start record
+ * (options, getcon); each helper function marked with EVENT_PHASE() (the
+ * create/attach/read/write/close functions and the waits) is a phase of
+ * its own; reap is from the helper's exit record to the runner reaping
+ * it. Helper phases come back through the event rings.
+ *
+ * Each (class, level pair, phase) has a log-linear histogram, eight
+ * buckets per power of two, so a percentile is within about 6% of the
+ * true value. Histograms of the same phase add, so under -j each worker
+ * merges its own into shared memory and the parent reports the sum.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mls_phase.h"
+
+struct phase_hist {
+    const char *cls;
+    const char *subj;
+    const char *obj;
+    char name[24];
+    int order;                  // first seen, for the report
+    uint32_t n;
+    uint64_t max;
+    uint32_t buckets[PHASE_BUCKETS];
+};
+
+struct phase_child {
+    pid_t pid;
+    uint64_t launched_ns;
+    uint64_t reaped_ns;
+};
+
+/* The histograms of every worker, in memory they share */
+struct phase_shared {
+    int nhists;
+    unsigned long dropped;
+    struct phase_hist hists[PHASE_MAX];
+};
+
+static struct phase_hist hists[PHASE_MAX];
+static int nhists = 0;
+static unsigned long dropped = 0;
+
+static const char *cur_cls = NULL;
+static const char *cur_subj = NULL;
+static const char *cur_obj = NULL;
+
+static struct phase_child children[PHASE_CHILDREN];
+static unsigned int nchildren = 0;
+
+
+static int phase_bucket(uint64_t ns)
+{
+    int k, i;
+
+    if (ns < PHASE_SUB) return (int)ns;
+    k = 63 - __builtin_clzll(ns);
+    i = (k - 2) * PHASE_SUB + (int)((ns >> (k - 3)) & (PHASE_SUB - 1));
+    return (i < PHASE_BUCKETS) ? i : PHASE_BUCKETS - 1;
+}
+
+/*
+ * The middle of bucket i
+ */
+static double phase_value(int i)
+{
+    int k = i / PHASE_SUB + 2;
+    uint64_t low;
+
+    if (i < PHASE_SUB) return i;
+    low = (uint64_t)(PHASE_SUB + i % PHASE_SUB) << (k - 3);
+    return low + ((uint64_t)1 << (k - 3)) / 2.0;
+}
+
+
+/*
+ * Attribute the phases that follow to a cell; a NULL class drops them
+ */
+void phase_cell(const char *cls, const char *subj, const char *obj)
+{
+    cur_cls = cls;
+    cur_subj = subj;
+    cur_obj = obj;
+}
+
+/*
+ * The histogram of (cls, subj, obj, phase) in hs, added if it is new
+ *
+ * Returns the histogram, or NULL if hs is full
+ */
+static struct phase_hist *phase_find(struct phase_hist *hs, int *n,
+                                     const char *cls, const char *subj,
+                                     const char *obj, const char *phase)
+{
+    struct phase_hist *h;
+    int i;
+
+    for (i = *n - 1; i >= 0; i--) {
+        h = &hs[i];
+        if (h->cls == cls && h->subj == subj && h->obj == obj &&
+            strcmp(h->name, phase) == 0) {
+            return h;
+        }
+    }
+    if (*n == PHASE_MAX) return NULL;
+    h = &hs[*n];
+    memset(h, 0, sizeof(*h));
+    h->cls = cls;
+    h->subj = subj;
+    h->obj = obj;
+    snprintf(h->name, sizeof(h->name), "%s", phase);
+    h->order = (*n)++;
+    return h;
+}
+
+void phase_add(const char *phase, uint64_t ns)
+{
+    struct phase_hist *h;
+
+    if (cur_cls == NULL) return;
+    h = phase_find(hists, &nhists, cur_cls, cur_subj, cur_obj, phase);
+    if (h == NULL) {
+        dropped++;
+        return;
+    }
+    h->n++;
+    if (ns > h->max) h->max = ns;
+    h->buckets[phase_bucket(ns)]++;
+}
+
+
+static struct phase_child *find_child(pid_t pid)
+{
+    int i;
+
+    for (i = 0; i < PHASE_CHILDREN; i++) {
+        if (children[i].pid == pid) return &children[i];
+    }
+    return NULL;
+}
+
+/*
+ * Remember when a helper was launched and reaped, for its events
+ */
+void phase_child(pid_t pid, uint64_t launched_ns, uint64_t reaped_ns)
+{
+    struct phase_child *c = find_child(pid);
+
+    // known from its launch; the reap fills in the rest
+    if (c == NULL) c = &children[nchildren++ % PHASE_CHILDREN];
+
+    c->pid = pid;
+    c->launched_ns = launched_ns;
+    c->reaped_ns = reaped_ns;
+}
+
+/*
+ * The event hook: turn a drained helper record into phases
+ */
+void phase_event(const struct event_rec *r)
+{
+    const struct phase_child *c = find_child(r->pid);
+
+    switch (r->type) {
+        case EV_START:
+            if (c != NULL && r->start_ns > c->launched_ns) {
+                phase_add("exec", r->start_ns - c->launched_ns);
+            }
+            phase_add("init", r->ts_ns - r->start_ns);
+            break;
+        case EV_PHASE:
+            phase_add(r->obj, r->ts_ns - r->start_ns);
+            break;
+        case EV_EXIT:
+            if (c != NULL && c->reaped_ns > r->ts_ns) {
+                phase_add("reap", c->reaped_ns - r->ts_ns);
+            }
+            break;
+    }
+}
+
+
+size_t phase_share_size(void)
+{
+    return sizeof(struct phase_shared);
+}
+
+/*
+ * Add this worker's histograms to to, phase_share_size() bytes shared with
+ * the parent. The class and level names are the same strings in every
+ * worker, as they were set up before the fork.
+ */
+void phase_merge(void *to)
+{
+    struct phase_shared *sh = to;
+    const struct phase_hist *h;
+    struct phase_hist *m;
+    int i, j;
+
+    sh->dropped += dropped;
+    for (i = 0; i < nhists; i++) {
+        h = &hists[i];
+        m = phase_find(sh->hists, &sh->nhists, h->cls, h->subj, h->obj,
+                       h->name);
+        if (m == NULL) {
+            sh->dropped += h->n;
+            continue;
+        }
+        m->n += h->n;
+        if (h->max > m->max) m->max = h->max;
+        for (j = 0; j < PHASE_BUCKETS; j++) m->buckets[j] += h->buckets[j];
+    }
+}
+
+/*
+ * Take the workers' merged histograms as this process's own
+ */
+void phase_adopt(const void *from)
+{
+    const struct phase_shared *sh = from;
+
+    nhists = sh->nhists;
+    dropped = sh->dropped;
+    memcpy(hists, sh->hists, nhists * sizeof(hists[0]));
+}
+
+
+static int by_cell(const void *a, const void *b)
+{
+    const struct phase_hist *x = a, *y = b;
+    int d;
+
+    if ((d = strcmp(x->cls, y->cls)) != 0) return d;
+    if ((d = strcmp(x->subj, y->subj)) != 0) return d;
+    if ((d = strcmp(x->obj, y->obj)) != 0) return d;
+    return x->order - y->order;
+}
+
+static double percentile(const struct phase_hist *h, double p)
+{
+    uint32_t want = (uint32_t)(h->n * p + 0.5);
+    uint32_t seen = 0;
+    int i;
+
+    if (want == 0) want = 1;
+    for (i = 0; i < PHASE_BUCKETS; i++) {
+        seen += h->buckets[i];
+        if (seen >= want) break;
+    }
+    // the top bucket is open-ended; never report more than the max
+    return (phase_value(i) < h->max) ? phase_value(i) : h->max;
+}
+
+/*
+ * p50, p99 and max of every phase, per class and level pair
+ */
+void phase_report(void)
+{
+    const struct phase_hist *h;
+    int i;
+
+    if (nhists == 0) return;
+    qsort(hists, nhists, sizeof(hists[0]), by_cell);
+    fprintf(stderr, "phase latency (ms)             n      p50      p99"
+            "      max\n");
+    for (i = 0; i < nhists; i++) {
+        h = &hists[i];
+        if (i == 0 || strcmp(h->cls, h[-1].cls) != 0 ||
+            strcmp(h->subj, h[-1].subj) != 0 ||
+            strcmp(h->obj, h[-1].obj) != 0) {
+            fprintf(stderr, "%s: %s -> %s\n", h->cls, h->subj, h->obj);
+        }
+        fprintf(stderr, "  %-24s %6u %8.3f %8.3f %8.3f\n", h->name, h->n,
+                percentile(h, 0.50) / 1e6, percentile(h, 0.99) / 1e6,
+                h->max / 1e6);
+    }
+    if (dropped > 0) {
+        fprintf(stderr, "  %lu samples dropped, more than %d histograms\n",
+                dropped, PHASE_MAX);
+    }
+}
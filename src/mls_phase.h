@@ -0,0 +1,30 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_PHASE_H__
+#define __TEST_MLS_PHASE_H__
+#include <stdint.h>
+#include <sys/types.h>
+#include "mls_event.h"
+
+#define PHASE_SUB      8        // buckets per power of two
+#define PHASE_BUCKETS  312      // up to 2^40 ns, about 18 minutes
+#define PHASE_MAX      1024     // (class, level pair, phase) histograms
+#define PHASE_CHILDREN 64       // recent helpers, to match their events
+
+void phase_cell(const char *cls, const char *subj, const char *obj);
+void phase_add(const char *phase, uint64_t ns);
+void phase_child(pid_t pid, uint64_t launched_ns, uint64_t reaped_ns);
+void phase_event(const struct event_rec *r);
+void phase_report(void);
+size_t phase_share_size(void);
+void phase_merge(void *to);
+void phase_adopt(const void *from);
+
+#endif
@@ -21,18 +21,35 @@
 #include <string.h>
 #include "mls_sem.h"
 #include "mls_support.h"
+#include "mls_child.h"
+#include "mls_event.h"
+#include "mls_phase.h"
 
-char *low_pipe = "low_fifo";
-char *high_pipe = "high_fifo";
+char low_pipe[MAX_STRING];
+char high_pipe[MAX_STRING];
+
+static const char *pipe_levels[2] = { "low", "high" };  // for phase_cell()
+static char pipe_rings[2][MAX_STRING];
 
 
 int test_pipe_init(void)
 {
-    if (create_file(LVL_LOW, log_low, NULL) != 0) {
-        return -1;
-    }
-    if (create_file(LVL_HIGH, log_high, NULL) != 0) {
-        return -1;
+    const char *lvls[2] = { LVL_LOW, LVL_HIGH };
+    char name[MAX_STRING];
+    int at;
+
+    worker_name(low_pipe, sizeof(low_pipe), "low_fifo");
+    worker_name(high_pipe, sizeof(high_pipe), "high_fifo");
+    worker_name(name, sizeof(name), "log/events.bin");
+    if (event_output(name) != 0) return -1;
+    event_hook = phase_event;
+    for (at = AT_LOW; at <= AT_HIGH; at++) {
+        snprintf(name, sizeof(name), "log/%s_events.ring", pipe_levels[at]);
+        worker_name(pipe_rings[at], sizeof(pipe_rings[at]), name);
+        if (create_ring(lvls[at], pipe_rings[at]) != 0 ||
+            event_attach(pipe_rings[at]) != 0) {
+            return -1;
+        }
     }
     unlink(low_pipe);
     unlink(high_pipe);
@@ -42,6 +59,7 @@ int test_pipe_init(void)
     if (create_fifo(LVL_HIGH, high_pipe) != 0) {
         return -1;
     }
+    return 0;
 }
 
 int test_pipe_cleanup(void)
@@ -52,110 +70,156 @@ int test_pipe_cleanup(void)
 
 /*****************************************************************************
  * Pipes
+ *
+ * The helpers open with O_NONBLOCK and wait with a deadline, so a reader
+ * and its writer are started together rather than one after the other.
+ * Like the matrix helpers, they log to the event ring of their level, and
+ * each cell's phases are reported as a pipes cell.
  */
 
-static void test_low_read_low(void) 
+static void pipe_argv(char *argv[8], int at, const char *test,
+                      const char *fifo)
 {
-    char * const argv1[] = {
-        "./mls_pipe_helper",
-        "--test", "3",
-        "--output", log_low,
-        "--file", low_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_LOW, argv1);
-    char * const argv2[] = {
-        "./mls_pipe_helper",
-        "--test", "1",
-        "--output", log_low,
-        "--file", low_pipe,
-        NULL
+    argv[0] = "./mls_pipe_helper";
+    argv[1] = "--test";
+    argv[2] = (char *)test;
+    argv[3] = "--events";
+    argv[4] = pipe_rings[at];
+    argv[5] = "--file";
+    argv[6] = (char *)fifo;
+    argv[7] = NULL;
+}
+
+/*
+ * Attribute the phases of a cell by subj to a FIFO at obj; a cell ends
+ * with subj -1, which drains the rings first
+ */
+static void pipe_cell(int subj, int obj)
+{
+    if (subj < 0) {
+        event_drain();
+        phase_cell(NULL, NULL, NULL);
+        return;
+    }
+    phase_cell("pipes", pipe_levels[subj], pipe_levels[obj]);
+}
+
+/*
+ * A helper expected to be denied needs no other end
+ */
+static void pipe_alone(int at, const char *test, const char *fifo)
+{
+    char *argv[8];
+
+    pipe_cell(at, fifo == high_pipe ? AT_HIGH : AT_LOW);
+    pipe_argv(argv, at, test, fifo);
+    fork_to_lvl(at == AT_LOW ? LVL_LOW : LVL_HIGH, argv);
+    pipe_cell(-1, -1);
+}
+
+#define PIPE_READER 0
+#define PIPE_WRITER 1
+
+/*
+ * Reap one end; only the end the cell is about is asserted, the other
+ * is there to open the FIFO and is just reported
+ */
+static void pipe_end(const struct mls_child *c, int checked)
+{
+    if (checked) {
+        child_exit_ok(c);
+    } else if (WIFEXITED(c->status)) {
+        fprintf(stderr, "other end %d exited with status %d\n", c->pid,
+                WEXITSTATUS(c->status));
+    } else {
+        fprintf(stderr, "other end %d exited with wait status %#x\n",
+                c->pid, c->status);
+    }
+}
+
+/*
+ * Run a reader and a writer together, asserting on end check
+ */
+static void pipe_pair(int reader, const char *rtest, int writer,
+                      const char *wtest, const char *fifo, int check)
+{
+    struct mls_child children[2];
+    struct child_set set;
+    struct mls_child *c;
+    char *argvs[2][8];
+    const char *lvls[2] = {
+        reader == AT_LOW ? LVL_LOW : LVL_HIGH,
+        writer == AT_LOW ? LVL_LOW : LVL_HIGH,
     };
-    fork_to_lvl(LVL_LOW, argv2);
+    int i;
+
+    pipe_argv(argvs[PIPE_READER], reader, rtest, fifo);
+    pipe_argv(argvs[PIPE_WRITER], writer, wtest, fifo);
+    if (child_set_init(&set) != 0) {
+        CU_FAIL("epoll failed");
+        return;
+    }
+    pipe_cell(check == PIPE_READER ? reader : writer,
+              fifo == high_pipe ? AT_HIGH : AT_LOW);
+    for (i = 0; i < 2; i++) {
+        if (child_launch(&children[i], lvls[i], argvs[i]) != 0) {
+            CU_FAIL("launch failed");
+            children[i].done = 1;
+            continue;
+        }
+        child_set_add(&set, &children[i]);
+    }
+    while ((c = child_set_next(&set, -1)) != NULL) {
+        pipe_end(c, c == &children[check]);
+    }
+    for (i = 0; i < 2; i++) {
+        if (!children[i].done) {
+            child_wait(&children[i]);
+            pipe_end(&children[i], i == check);
+        }
+    }
+    child_set_close(&set);
+    pipe_cell(-1, -1);
+}
+
+static void test_low_read_low(void) 
+{
+    pipe_pair(AT_LOW, "1", AT_LOW, "3", low_pipe, PIPE_READER);
 }
 
 static void test_low_read_high(void) 
 {
-    char * const argv[] = {
-        "./mls_pipe_helper",
-        "--test", "2",
-        "--output", log_low,
-        "--file", high_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_LOW, argv);
+    pipe_alone(AT_LOW, "2", high_pipe);
 }
 
 static void test_low_write_low(void) 
 {
-    char * const argv[] = {
-        "./mls_pipe_helper",
-        "--test", "3",
-        "--output", log_low,
-        "--file", low_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_LOW, argv);
+    pipe_pair(AT_LOW, "1", AT_LOW, "3", low_pipe, PIPE_WRITER);
 }
 
 static void test_low_write_high(void) 
 {
-    char * const argv[] = {
-        "./mls_pipe_helper",
-        "--test", "4",
-        "--output", log_low,
-        "--file", high_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_LOW, argv);
+    pipe_alone(AT_LOW, "4", high_pipe);
 }
 
 static void test_high_read_low(void) 
 {
-    char * const argv[] = {
-        "./mls_pipe_helper",
-        "--test", "1",
-        "--output", log_high,
-        "--file", low_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_HIGH, argv);
+    pipe_pair(AT_HIGH, "1", AT_LOW, "3", low_pipe, PIPE_READER);
 }
 
 static void test_high_read_high(void) 
 {
-    char * const argv[] = {
-        "./mls_pipe_helper",
-        "--test", "2",
-        "--output", log_high,
-        "--file", high_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_HIGH, argv);
+    pipe_pair(AT_HIGH, "2", AT_HIGH, "4", high_pipe, PIPE_READER);
 }
 
 static void test_high_write_low(void) 
 {
-    char * const argv[] = {
-        "./mls_pipe_helper",
-        "--test", "3",
-        "--output", log_high,
-        "--file", low_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_HIGH, argv);
+    pipe_alone(AT_HIGH, "3", low_pipe);
 }
 
 static void test_high_write_high(void) 
 {
-    char * const argv[] = {
-        "./mls_pipe_helper",
-        "--test", "4",
-        "--output", log_high,
-        "--file", high_pipe,
-        NULL
-    };
-    fork_to_lvl(LVL_HIGH, argv);
+    pipe_pair(AT_HIGH, "2", AT_HIGH, "4", high_pipe, PIPE_WRITER);
 }
 
 
@@ -165,12 +229,12 @@ static void test_high_write_high(void)
 
 CU_TestInfo pipe_tests[] = {
     {"test_low_read_low", test_low_read_low},
-    //{"test_low_read_high", test_low_read_high},
-    //{"test_low_write_low", test_low_write_low},
-    //{"test_low_write_high", test_low_write_high},
-    //{"test_high_read_low", test_high_read_low},
-    //{"test_high_read_high", test_high_read_high},
-    //{"test_high_write_low", test_high_write_low},
-    //{"test_high_write_high", test_high_write_high},
+    {"test_low_read_high", test_low_read_high},
+    {"test_low_write_low", test_low_write_low},
+    {"test_low_write_high", test_low_write_high},
+    {"test_high_read_low", test_high_read_low},
+    {"test_high_read_high", test_high_read_high},
+    {"test_high_write_low", test_high_write_low},
+    {"test_high_write_high", test_high_write_high},
     CU_TEST_INFO_NULL
-};
\ No newline at end of file
+};
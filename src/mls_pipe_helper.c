@@ -1,6 +1,14 @@
 /* 
  * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
  *
+ * FIFO driver. Both ends open with O_NONBLOCK, so neither waits in open()
+ * for the other: a reader's open returns at once, and a writer's fails
+ * with ENXIO until a reader is there, which is retried until the
+ * deadline. A reader then polls for the data, with the same deadline.
+ * The runner starts a reader and a writer together; a denied open fails
+ * with EACCES before the FIFO is even looked at, so a helper that is
+ * expected to be denied runs alone.
+ *
  * \author Copyright (c) 2013, Mark Gondree
  * \author Copyright (c) 2013, Aaron Flemming
  * \date 2013-2013
@@ -11,33 +19,105 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
-#include <getopt.h>
 #include <string.h>
 #include <errno.h>
-#include <time.h>
 #include <fcntl.h>
-#include <selinux/selinux.h>
-#include <selinux/context.h> // for context-mangling functions
+#include <poll.h>
 #include "mls_file.h"
 #include "mls_support.h"
+#include "mls_helper.h"
+#include "mls_wait.h"
+#include "mls_event.h"
 
 
-void read_low(int level, const char *fname)
+static int open_reader(const char *fname)
 {
-    int fd = -1;
-    static char buf[10];
-    int status = -1;
+    EVENT_PHASE();
+    int fd;
 
-    printf("%s(..., %s)\n", __func__, fname);
+    fd = open(fname, O_RDONLY | O_NONBLOCK);
+    if (fd == -1) {
+        printf("open(%s)\n", fname);
+        perror("open failed");
+    }
     fflush(stdout);
+    return fd;
+}
+
+/*
+ * Open for writing once a reader has the FIFO open; errno is left as the
+ * last open() set it
+ */
+static int open_writer(const char *fname)
+{
+    EVENT_PHASE();
+    struct deadline dl;
+    int fd, err;
 
-    fd = open(fname, O_RDONLY);
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    while ((fd = open(fname, O_WRONLY | O_NONBLOCK)) == -1) {
+        err = errno;
+        // only a missing reader is worth waiting for
+        if (err != ENXIO || !wait_retry(&dl)) break;
+    }
     if (fd == -1) {
         printf("open(%s)\n", fname);
         perror("open failed");
+    }
+    fflush(stdout);
+    if (fd == -1) errno = err;      // stdio may have set it
+    return fd;
+}
 
+/*
+ * Poll for the writer's record and check it is the one expected
+ */
+static void read_fifo(int fd, const char *expect)
+{
+    EVENT_PHASE();
+    struct deadline dl;
+    struct pollfd pfd = { fd, POLLIN, 0 };
+    char buf[MAX_STRING];
+    ssize_t status = -1;
+    int n;
+
+    memset(buf, 0, sizeof(buf));
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    do {
+        n = poll(&pfd, 1, deadline_left_ms(&dl));
+    } while (n == -1 && errno == EINTR);
+    if (n == 1) {
+        status = read(fd, buf, sizeof(buf) - 1);
+    } else {
+        printf("no data before the deadline\n");
     }
+    printf("File contains: %s\n", expect);
+    printf("We read %zd:  %s\n", status, buf);
+    fflush(stdout);
+    assert(status > 0 && strcmp(buf, expect) == 0);
+    printf("PASS\n");
+}
+
+static void write_fifo(int level, int fd, const char *data)
+{
+    EVENT_PHASE();
+    ssize_t status;
+
+    status = write(fd, data, strlen(data) + 1);
+    printf("Write at %s\n", (level == AT_LOW) ? LVL_LOW : LVL_HIGH);
+    printf("We wrote %zd chars\n", status);
     fflush(stdout);
+    assert(status > 0);
+    printf("PASS\n");
+}
+
+
+static void read_low(int level, const char *fname)
+{
+    int fd;
+
+    printf("%s(..., %s)\n", __func__, fname);
+    fd = open_reader(fname);
     if (level == AT_LOW) {
         // low should be able to read low
         assert(fd != -1);
@@ -47,39 +127,17 @@ void read_low(int level, const char *fname)
     } else {
         assert(0 != 0);
     }
-	printf("got here"); fflush(stdout);
-    if (fd != -1) {
-        status = read(fd, buf, sizeof(buf));
-        printf("File contains: %s\n", LOW_CONTENTS);
-        printf("We read %d:  %s\n", status, buf);
-        
-        if (strcmp(buf, LOW_CONTENTS) != 0) {
-            assert(0 != 1);
-        } else {
-            printf("PASS\n");
-        }
-    }
-    fflush(stdout);
-    if (fd != -1) {
-        close(fd);
-    }
+    read_fifo(fd, LOW_CONTENTS);
+    close(fd);
 }
 
 
-void read_high(int level, const char *fname)
+static void read_high(int level, const char *fname)
 {
-    int fd = -1;
-    static char buf[10];
-    int status;
+    int fd;
 
     printf("%s(..., %s)\n", __func__, fname);
-
-    fd = open(fname, O_RDONLY);
-    if (fd == -1) {
-        printf("open(%s)\n", fname);
-        perror("open failed");
-
-    }
+    fd = open_reader(fname);
     if (level == AT_LOW) {
         // low should not be able to read high
         assert(fd == -1);
@@ -90,83 +148,50 @@ void read_high(int level, const char *fname)
     } else {
         assert(0 != 1);
     }
-
-    if (fd != -1) {
-        status = read(fd, buf, sizeof(buf));
-        printf("File contains: %s\n", HIGH_CONTENTS);
-        printf("We read %d:  %s\n", status, buf);
-        
-        if (strcmp(buf, HIGH_CONTENTS) != 0) {
-            assert(0 != 1);
-        } else {
-            printf("PASS\n");
-        }
-    }
     if (fd != -1) {
+        read_fifo(fd, HIGH_CONTENTS);
         close(fd);
     }
 }
 
 
-void write_low(int level, const char *fname)
+static void write_low(int level, const char *fname)
 { 
-    int fd = -1;
-    int status;
-    time_t t;
+    int fd;
 
     printf("%s(..., %s)\n", __func__, fname);
-    time(&t);
-
-    fd = open(fname, O_WRONLY);
-    if (fd == -1) {
-        printf("open(%s)\n", fname);
-        perror("open failed");
-
-    }
+    fd = open_writer(fname);
     if (level == AT_LOW) {
         // low should be able to write low
         assert(fd != -1);
     } else if (level == AT_HIGH) {
         // high should not be able to write low
-        assert(fd == -1);
+        assert(fd == -1 && errno != ENXIO);
         printf("PASS\n");
     } else {
         assert(0 != 1);
     }
-
-    if (fd != -1) {
-        status = write(fd, LOW_CONTENTS, sizeof(LOW_CONTENTS));
-        printf("Write at %s\n", (level == AT_LOW) ? LVL_LOW : LVL_HIGH);
-        printf("We wrote %d chars\n", status);
-        assert(status > 0);
-        printf("PASS\n");
-    }
     if (fd != -1) {
+        write_fifo(level, fd, LOW_CONTENTS);
         close(fd);
     }
 }
 
 
-void write_high(int level, const char *fname)
+static void write_high(int level, const char *fname)
 {
-    int fd = -1;
-    int status;
-    time_t t;
+    int fd;
 
     printf("%s(..., %s)\n", __func__, fname);
-    time(&t);
-
-    fd = open(fname, O_WRONLY);
-    if (fd == -1) {
-        printf("open(%s)\n", fname);
-        perror("open failed");
-
-    }
+    fd = open_writer(fname);
     if (level == AT_LOW) {
         if (fd != -1) {
             // This is okay under Bell-LaPadula model
             // but most real systems don't implement it
             printf("Wow, neat -- low can write to high\n");
+        } else if (errno == ENXIO) {
+            // allowed, but the runner starts no reader for it
+            printf("Wow, neat -- low may open high for writing\n");
         }
     } else if (level == AT_HIGH) {
         // high should be able to write high
@@ -175,92 +200,19 @@ void write_high(int level, const char *fname)
     } else {
         assert(0 != 1);
     }
-
-    if (fd != -1) {
-        status = write(fd, HIGH_CONTENTS, sizeof(HIGH_CONTENTS));
-        printf("Write at %s\n", (level == AT_LOW) ? LVL_LOW : LVL_HIGH);
-        printf("We wrote %d chars\n", status);
-        assert(status > 0);
-        printf("PASS\n");
-    }
     if (fd != -1) {
+        write_fifo(level, fd, HIGH_CONTENTS);
         close(fd);
     }
 }
 
 
-int main(int argc, char* argv[])
+int pipe_helper(const struct helper_args *args)
 {
-    int opt, option_index;
-    int test_num  = -1;
-    int level = -1;
-    context_t ctx = NULL;
-    security_context_t ctx_check = NULL;
-    char *path = NULL;
-    char *log_path = NULL;
-    time_t t;
+    int level = args->level;
+    char *path = args->path;
 
-    static struct option long_options[] = {
-      {"output",  required_argument, 0, 'o'},
-      {"test",    required_argument, 0, 't'},
-      {"file",    required_argument, 0, 'f'},
-      {0, 0, 0, 0}
-    };
-    
-    while ((opt = getopt_long(argc, argv, "o:t:f:",
-                              long_options, &option_index)) != -1)
-    {
-        switch (opt) {            
-            case 'o':
-                log_path = optarg;
-                if (freopen(log_path, "a+", stdout) == NULL) {
-                    exit(-1);
-                }
-                if (freopen(log_path, "a+", stderr) == NULL) {
-                    exit(-1);
-                }
-                break;
-            case 't':
-                test_num = atoi(optarg);
-                break;
-            case 'f':
-                path = optarg;
-                break;
-            default:
-                printf("bad argument.\n");
-                exit(-1);
-            }
-    }     
-
-    if (test_num == -1) {
-        printf("no test specified.\n");
-        exit(-1);
-    } else if (path == NULL) {
-        printf("no path specified.\n");
-        exit(-1);
-    }
-
-    time(&t);
-    printf("\n%s", ctime(&t));
-    getcon(&ctx_check);
-    printf("Context: '%s'\n", ctx_check); 
-    ctx = context_new(ctx_check);
-    const char *range = context_range_get(ctx);
-
-    if (strncmp(LVL_HIGH"-", range, sizeof(LVL_HIGH"-")-1) == 0) {
-        level = AT_HIGH;
-        printf("process is at high\n");
-    } else if (strncmp(LVL_LOW"-", range, sizeof(LVL_LOW"-")-1) == 0) {
-        level = AT_LOW;
-        printf("process is at low\n");
-    } else {
-        printf("unexpected level\n");
-        exit(-1);
-    }
-
-    fflush(stdout); fflush(stderr);
-
-    switch(test_num) {
+    switch(args->test_num) {
         case 1:
             read_low(level, path);
             break;
@@ -280,4 +232,3 @@ int main(int argc, char* argv[])
     }
     return 0;
 }
-
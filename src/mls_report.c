@@ -0,0 +1,349 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Streaming reporters. With -J the run is written as JUnit XML and with
+ * -T as TAP, each test as soon as it completes, from CUnit's test start
+ * and complete handlers. Every helper run by a test is a step, with its
+ * command, level, exit status and wall time. Only the steps of the test
+ * in progress are held, so memory does not grow with the matrix. In
+ * parallel mode each worker writes its own file (report.w<N>.xml).
+ *
+ * CUnit's basic interface installs its own handlers, so with a reporter
+ * the serial run goes through report_run(), which prints the same
+ * verbose console output itself.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <CUnit/CUnit.h>
+#include <CUnit/TestRun.h>
+#include "mls_report.h"
+#include "mls_support.h"
+
+const char *report_junit = NULL;
+const char *report_tap = NULL;
+
+struct report_step {
+    char what[MAX_STRING];
+    char lvl[MAX_STRING];
+    int status;
+    double secs;
+};
+
+static FILE *junit = NULL;
+static FILE *tap = NULL;
+static int console = 0;         // echo CUnit's verbose output on stdout
+
+static CU_pSuite suite = NULL;  // suite of the last test started
+static struct timespec test_start;
+static struct report_step steps[REPORT_MAX_STEPS];
+static int nsteps = 0;
+static int dropped = 0;         // steps past REPORT_MAX_STEPS
+static unsigned int ntap = 0;
+static CU_pSuite failed = NULL; // suite whose init failure was reported
+
+
+static double since(const struct timespec *start)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) +
+           (now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+static void xml_puts(FILE *f, const char *s)
+{
+    for (; *s; s++) {
+        switch (*s) {
+            case '&':  fputs("&amp;", f); break;
+            case '<':  fputs("&lt;", f); break;
+            case '>':  fputs("&gt;", f); break;
+            case '"':  fputs("&quot;", f); break;
+            default:   fputc(*s, f);
+        }
+    }
+}
+
+static void yaml_puts(FILE *f, const char *s)
+{
+    fputc('"', f);
+    for (; *s; s++) {
+        if (*s == '"' || *s == '\\') fputc('\\', f);
+        fputc(*s, f);
+    }
+    fputc('"', f);
+}
+
+
+/*
+ * Record a helper run by the test in progress
+ */
+void report_step(const char *what, const char *lvl, int status, double secs)
+{
+    struct report_step *s;
+
+    if (junit == NULL && tap == NULL) return;
+    if (nsteps == REPORT_MAX_STEPS) {
+        dropped++;
+        return;
+    }
+    s = &steps[nsteps++];
+    snprintf(s->what, sizeof(s->what), "%s", what);
+    snprintf(s->lvl, sizeof(s->lvl), "%s", lvl);
+    s->status = status;
+    s->secs = secs;
+}
+
+
+/*
+ * Close the previous suite's element, if any, and open s's
+ */
+static void junit_suite(const CU_pSuite s)
+{
+    if (suite != NULL) fprintf(junit, "  </testsuite>\n");
+    fprintf(junit, "  <testsuite name=\"");
+    xml_puts(junit, s->pName);
+    fprintf(junit, "\">\n");
+}
+
+static void suite_begin(const CU_pSuite s)
+{
+    if (s == suite) return;
+    if (junit != NULL) junit_suite(s);
+    if (tap != NULL) fprintf(tap, "# %s\n", s->pName);
+    if (console) printf("\nSuite: %s", s->pName);
+    suite = s;
+}
+
+static void test_start_handler(const CU_pTest test, const CU_pSuite s)
+{
+    suite_begin(s);
+    if (console) printf("\n  Test: %s ...", test->pName);
+    nsteps = 0;
+    dropped = 0;
+    clock_gettime(CLOCK_MONOTONIC, &test_start);
+}
+
+static void junit_test(const CU_pTest test, const CU_pSuite s,
+                       CU_pFailureRecord fail, double secs)
+{
+    CU_pFailureRecord f;
+    int i;
+
+    fprintf(junit, "    <testcase classname=\"");
+    xml_puts(junit, s->pName);
+    fprintf(junit, "\" name=\"");
+    xml_puts(junit, test->pName);
+    fprintf(junit, "\" time=\"%.6f\">\n", secs);
+    for (f = fail; f != NULL && f->pTest == test; f = f->pNext) {
+        fprintf(junit, "      <failure message=\"");
+        xml_puts(junit, f->strCondition ? f->strCondition : "");
+        fprintf(junit, "\">%s:%u</failure>\n",
+                f->strFileName ? f->strFileName : "", f->uiLineNumber);
+    }
+    if (nsteps > 0) {
+        fprintf(junit, "      <system-out>");
+        for (i = 0; i < nsteps; i++) {
+            fprintf(junit, "%8.3f ms  status %3d  ", steps[i].secs * 1000,
+                    steps[i].status);
+            xml_puts(junit, steps[i].lvl);
+            fputs("  ", junit);
+            xml_puts(junit, steps[i].what);
+            fputc('\n', junit);
+        }
+        if (dropped > 0) fprintf(junit, "%d more steps\n", dropped);
+        fprintf(junit, "</system-out>\n");
+    }
+    fprintf(junit, "    </testcase>\n");
+    fflush(junit);
+}
+
+static void tap_test(const CU_pTest test, const CU_pSuite s,
+                     CU_pFailureRecord fail, double secs)
+{
+    CU_pFailureRecord f;
+    int i;
+
+    fprintf(tap, "%s %u - %s: %s\n",
+            (fail != NULL && fail->pTest == test) ? "not ok" : "ok", ++ntap,
+            s->pName, test->pName);
+    fprintf(tap, "  ---\n  duration_ms: %.3f\n", secs * 1000);
+    if (fail != NULL && fail->pTest == test) {
+        fprintf(tap, "  failures:\n");
+        for (f = fail; f != NULL && f->pTest == test; f = f->pNext) {
+            fprintf(tap, "    - { at: \"%s:%u\", condition: ",
+                    f->strFileName ? f->strFileName : "", f->uiLineNumber);
+            yaml_puts(tap, f->strCondition ? f->strCondition : "");
+            fprintf(tap, " }\n");
+        }
+    }
+    if (nsteps > 0) {
+        fprintf(tap, "  steps:\n");
+        for (i = 0; i < nsteps; i++) {
+            fprintf(tap, "    - { level: ");
+            yaml_puts(tap, steps[i].lvl);
+            fprintf(tap, ", status: %d, duration_ms: %.3f, command: ",
+                    steps[i].status, steps[i].secs * 1000);
+            yaml_puts(tap, steps[i].what);
+            fprintf(tap, " }\n");
+        }
+        if (dropped > 0) fprintf(tap, "  steps_dropped: %d\n", dropped);
+    }
+    fprintf(tap, "  ...\n");
+    fflush(tap);
+}
+
+static void test_complete_handler(const CU_pTest test, const CU_pSuite s,
+                                  const CU_pFailureRecord fail)
+{
+    double secs = since(&test_start);
+    CU_pFailureRecord f;
+    int i;
+
+    if (junit != NULL) junit_test(test, s, fail, secs);
+    if (tap != NULL) tap_test(test, s, fail, secs);
+    nsteps = 0;
+
+    if (!console) return;
+    if (fail == NULL || fail->pTest != test) {
+        printf("passed");
+        return;
+    }
+    printf("FAILED");
+    for (i = 1, f = fail; f != NULL && f->pTest == test; f = f->pNext, i++) {
+        printf("\n    %d. %s:%u  - %s", i,
+               f->strFileName ? f->strFileName : "", f->uiLineNumber,
+               f->strCondition ? f->strCondition : "");
+    }
+}
+
+/*
+ * The suite's tests never ran; report each of them as failed
+ */
+static void suite_init_failure_handler(const CU_pSuite s)
+{
+    CU_pTest test;
+
+    // a scheduler worker runs a suite's init once per test
+    if (s == failed) return;
+    failed = s;
+    if (console) {
+        printf("\nWARNING - Suite initialization failed for '%s'.", s->pName);
+    }
+    if (junit != NULL && s != suite) junit_suite(s);
+    if (tap != NULL) fprintf(tap, "# %s\n", s->pName);
+    suite = s;
+    for (test = s->pTest; test != NULL; test = test->pNext) {
+        if (junit != NULL) {
+            fprintf(junit, "    <testcase classname=\"");
+            xml_puts(junit, s->pName);
+            fprintf(junit, "\" name=\"");
+            xml_puts(junit, test->pName);
+            fprintf(junit, "\" time=\"0\">\n      <error message=\"suite "
+                    "initialization failed\"/>\n    </testcase>\n");
+        }
+        if (tap != NULL) {
+            fprintf(tap, "not ok %u - %s: %s # suite initialization failed\n",
+                    ++ntap, s->pName, test->pName);
+        }
+    }
+}
+
+
+/*
+ * Open the report files, if any were asked for, and install the handlers.
+ * A scheduler worker calls this itself, so each gets its own files.
+ */
+int report_open(void)
+{
+    char path[MAX_STRING];
+
+    if (report_junit != NULL) {
+        junit = fopen(worker_name(path, sizeof(path), report_junit), "w");
+        if (junit == NULL) {
+            perror("open JUnit report failed");
+            return -1;
+        }
+        fprintf(junit, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                       "<testsuites name=\"mls_test\">\n");
+        fflush(junit);
+    }
+    if (report_tap != NULL) {
+        tap = fopen(worker_name(path, sizeof(path), report_tap), "w");
+        if (tap == NULL) {
+            perror("open TAP report failed");
+            return -1;
+        }
+        fprintf(tap, "TAP version 13\n");
+        fflush(tap);
+    }
+    if (junit == NULL && tap == NULL) return 0;
+
+    suite = failed = NULL;
+    ntap = 0;
+    CU_set_test_start_handler(test_start_handler);
+    CU_set_test_complete_handler(test_complete_handler);
+    CU_set_suite_init_failure_handler(suite_init_failure_handler);
+    return 0;
+}
+
+/*
+ * Close the open elements and the plan; TAP allows the plan at the end
+ */
+void report_close(void)
+{
+    if (junit != NULL) {
+        if (suite != NULL) fprintf(junit, "  </testsuite>\n");
+        fprintf(junit, "</testsuites>\n");
+        fclose(junit);
+        junit = NULL;
+    }
+    if (tap != NULL) {
+        fprintf(tap, "1..%u\n", ntap);
+        fclose(tap);
+        tap = NULL;
+    }
+    suite = NULL;
+}
+
+
+/*
+ * Run the registry serially with the reporters, printing what
+ * CU_basic_run_tests() would in verbose mode
+ */
+CU_ErrorCode report_run(void)
+{
+    CU_pTestRegistry reg = CU_get_registry();
+    CU_pRunSummary sum;
+    struct timespec start;
+    CU_ErrorCode err;
+
+    if (report_open() != 0) return CUE_NOMEMORY;
+    // unbuffered, as the basic interface has it, so forks don't repeat it
+    setvbuf(stdout, NULL, _IONBF, 0);
+    console = 1;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    err = CU_run_all_tests();
+    report_close();
+
+    sum = CU_get_run_summary();
+    printf("\n\n--Run Summary: Type      Total     Ran  Passed  Failed\n");
+    printf("               suites %8u%8u     n/a%8u\n",
+           reg->uiNumberOfSuites, sum->nSuitesRun, sum->nSuitesFailed);
+    printf("               tests  %8u%8u%8u%8u\n", reg->uiNumberOfTests,
+           sum->nTestsRun, sum->nTestsRun - sum->nTestsFailed,
+           sum->nTestsFailed);
+    printf("               asserts%8u%8u%8u%8u\n", sum->nAsserts,
+           sum->nAsserts, sum->nAsserts - sum->nAssertsFailed,
+           sum->nAssertsFailed);
+    printf("\nElapsed time = %8.3f seconds\n", since(&start));
+    return err;
+}
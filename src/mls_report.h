@@ -0,0 +1,24 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_REPORT_H__
+#define __TEST_MLS_REPORT_H__
+#include <CUnit/CUnit.h>
+
+#define REPORT_MAX_STEPS 64     // steps kept for the test in progress
+
+extern const char *report_junit;    // -J path, or NULL
+extern const char *report_tap;      // -T path, or NULL
+
+int report_open(void);
+void report_close(void);
+CU_ErrorCode report_run(void);
+void report_step(const char *what, const char *lvl, int status, double secs);
+
+#endif
@@ -0,0 +1,291 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Parallel suite scheduler. Every registered test is handed to one of a
+ * pool of forked workers; each worker renames its objects (segments, ftok
+ * anchors, logs) so no two workers touch the same object. Results are
+ * collected in shared memory and printed in registry order, in the same
+ * layout as the serial CUnit basic report. The matrix tallies share the
+ * same mapping, after the results; each worker merges its launch, context
+ * and phase counters into it as it exits, and the parent reports them all
+ * once.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sched.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+#include <CUnit/CUnit.h>
+#include <CUnit/TestRun.h>
+#include "mls_sched.h"
+#include "mls_support.h"
+#include "mls_agent.h"
+#include "mls_child.h"
+#include "mls_matrix.h"
+#include "mls_event.h"
+#include "mls_report.h"
+#include "mls_phase.h"
+
+struct sched_shared {
+    unsigned int next;              // next unclaimed test
+    int lock;                       // held by a worker merging its counters
+    struct launch_stats launch;
+    struct context_stats contexts;
+    struct sched_result res[];
+};
+
+#define SCHED_ALIGN(n) (((n) + 15) & ~(size_t)15)
+
+struct sched_job {
+    CU_pSuite suite;
+    CU_pTest test;
+};
+
+
+/*
+ * Parse the argument of -j; 0 means one worker per online cpu
+ */
+int sched_jobs(const char *arg)
+{
+    int jobs = atoi(arg);
+
+    if (jobs <= 0) {
+        jobs = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    }
+    return (jobs > 0) ? jobs : 1;
+}
+
+
+/*
+ * Flatten the registry into run order
+ */
+static int collect_jobs(struct sched_job **jobs)
+{
+    CU_pTestRegistry reg = CU_get_registry();
+    CU_pSuite suite;
+    CU_pTest test;
+    int n = 0;
+
+    *jobs = calloc(reg->uiNumberOfTests, sizeof(struct sched_job));
+    if (*jobs == NULL) return -1;
+
+    for (suite = reg->pSuite; suite != NULL; suite = suite->pNext) {
+        if (!suite->fActive) continue;
+        for (test = suite->pTest; test != NULL; test = test->pNext) {
+            if (!test->fActive) continue;
+            (*jobs)[n].suite = suite;
+            (*jobs)[n].test = test;
+            n++;
+        }
+    }
+    return n;
+}
+
+
+static void record_result(struct sched_result *res, int worker)
+{
+    CU_pRunSummary summary = CU_get_run_summary();
+    CU_pFailureRecord f;
+
+    res->worker = worker;
+    res->init_failed = (summary->nSuitesFailed > 0);
+    res->asserts = summary->nAsserts;
+    res->asserts_failed = summary->nAssertsFailed;
+    res->nfail = 0;
+    for (f = CU_get_failure_list(); f != NULL; f = f->pNext) {
+        if (res->nfail == SCHED_MAX_FAILS) break;
+        res->fail[res->nfail].line = f->uiLineNumber;
+        snprintf(res->fail[res->nfail].file, sizeof(res->fail[0].file),
+                 "%s", f->strFileName ? f->strFileName : "");
+        snprintf(res->fail[res->nfail].cond, sizeof(res->fail[0].cond),
+                 "%s", f->strCondition ? f->strCondition : "");
+        res->nfail++;
+    }
+    res->done = 1;
+}
+
+
+static void worker_main(int worker, struct sched_shared *shared,
+                        void *phases, struct sched_job *jobs, int njobs)
+{
+    unsigned int i;
+
+    worker_setup(worker);
+    report_open();
+    while ((i = __sync_fetch_and_add(&shared->next, 1)) < (unsigned int)njobs) {
+        fprintf(stderr, "worker %d: %s/%s\n", worker,
+                jobs[i].suite->pName, jobs[i].test->pName);
+        CU_run_test(jobs[i].suite, jobs[i].test);
+        record_result(&shared->res[i], worker);
+    }
+    report_close();
+    agents_stop();
+    event_report();
+
+    while (__sync_lock_test_and_set(&shared->lock, 1)) sched_yield();
+    launch_merge(&shared->launch);
+    context_merge(&shared->contexts);
+    phase_merge(phases);
+    __sync_lock_release(&shared->lock);
+    fflush(stdout); fflush(stderr);
+    _exit(0);
+}
+
+
+/*
+ * Print the merged results the way CU_basic_run_tests() does in verbose mode
+ */
+static void print_report(struct sched_job *jobs, struct sched_result *res,
+                         int njobs, double elapsed)
+{
+    CU_pTestRegistry reg = CU_get_registry();
+    CU_pSuite suite = NULL;
+    unsigned int suites_run = 0, suites_failed = 0;
+    unsigned int tests_run = 0, tests_failed = 0;
+    unsigned int asserts = 0, asserts_failed = 0;
+    int suite_init_failed = 0;
+    int i, j;
+
+#ifdef CU_VERSION
+    printf("\n\n     CUnit - A Unit testing framework for C - Version "
+           CU_VERSION "\n     http://cunit.sourceforge.net/\n\n");
+#endif
+
+    for (i = 0; i < njobs; i++) {
+        if (jobs[i].suite != suite) {
+            suite = jobs[i].suite;
+            suite_init_failed = 0;
+            for (j = i; j < njobs && jobs[j].suite == suite; j++) {
+                if (res[j].init_failed) suite_init_failed = 1;
+            }
+            if (suite_init_failed) {
+                printf("\nWARNING - Suite initialization failed for '%s'.",
+                       suite->pName);
+                suites_failed++;
+            } else {
+                printf("\nSuite: %s", suite->pName);
+                suites_run++;
+            }
+        }
+        if (suite_init_failed) continue;
+
+        printf("\n  Test: %s ...", jobs[i].test->pName);
+        if (!res[i].done) {
+            printf("FAILED\n    1. %s:%u  - %s", __FILE__, __LINE__,
+                   "worker exited before completing the test");
+            tests_run++;
+            tests_failed++;
+            continue;
+        }
+        tests_run++;
+        asserts += res[i].asserts;
+        asserts_failed += res[i].asserts_failed;
+        if (res[i].asserts_failed == 0) {
+            printf("passed");
+            continue;
+        }
+        tests_failed++;
+        printf("FAILED");
+        for (j = 0; j < (int)res[i].nfail; j++) {
+            printf("\n    %d. %s:%u  - %s", j + 1, res[i].fail[j].file,
+                   res[i].fail[j].line, res[i].fail[j].cond);
+        }
+    }
+
+    printf("\n\n--Run Summary: Type      Total     Ran  Passed  Failed\n");
+    printf("               suites %8u%8u     n/a%8u\n",
+           reg->uiNumberOfSuites, suites_run, suites_failed);
+    printf("               tests  %8u%8u%8u%8u\n",
+           reg->uiNumberOfTests, tests_run, tests_run - tests_failed,
+           tests_failed);
+    printf("               asserts%8u%8u%8u%8u\n",
+           asserts, asserts, asserts - asserts_failed, asserts_failed);
+    printf("\nElapsed time = %8.3f seconds\n", elapsed);
+}
+
+
+/*
+ * Run the registry on a pool of jobs workers
+ */
+CU_ErrorCode run_parallel(int jobs)
+{
+    struct sched_job *job_list = NULL;
+    struct sched_shared *shared = NULL;
+    struct timespec start, end;
+    size_t shared_size, matrix_off, phase_off;
+    pid_t *pids = NULL;
+    int njobs;
+    int status;
+    int w;
+
+    njobs = collect_jobs(&job_list);
+    if (njobs < 0) return CUE_NOMEMORY;
+    if (jobs > njobs) jobs = (njobs > 0) ? njobs : 1;
+
+    matrix_off = SCHED_ALIGN(sizeof(*shared) +
+                             njobs * sizeof(struct sched_result));
+    phase_off = SCHED_ALIGN(matrix_off + matrix_share_size());
+    shared_size = phase_off + phase_share_size();
+    shared = mmap(NULL, shared_size, PROT_READ | PROT_WRITE,
+                  MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    pids = calloc(jobs, sizeof(pid_t));
+    if (shared == MAP_FAILED || pids == NULL) {
+        perror("scheduler setup failed");
+        free(job_list);
+        free(pids);
+        return CUE_NOMEMORY;
+    }
+    memset(shared, 0, shared_size);
+    matrix_share((char *)shared + matrix_off);
+
+    fprintf(stderr, "running %d tests on %d workers\n", njobs, jobs);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    fflush(stdout); fflush(stderr);
+
+    for (w = 0; w < jobs; w++) {
+        pids[w] = fork();
+        if (pids[w] == 0) {
+            worker_main(w, shared, (char *)shared + phase_off, job_list,
+                        njobs);
+        } else if (pids[w] == -1) {
+            perror("fork failed");
+        }
+    }
+
+    for (w = 0; w < jobs; w++) {
+        if (pids[w] <= 0) continue;
+        while (waitpid(pids[w], &status, 0) == -1 && errno == EINTR)
+            ;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            fprintf(stderr, "worker %d did not exit cleanly\n", w);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    print_report(job_list, shared->res, njobs,
+                 (end.tv_sec - start.tv_sec) +
+                 (end.tv_nsec - start.tv_nsec) / 1e9);
+    launch_adopt(&shared->launch);
+    launch_report();
+    context_adopt(&shared->contexts);
+    context_report();
+    matrix_report();
+    phase_adopt((char *)shared + phase_off);
+    phase_report();
+
+    munmap(shared, shared_size);
+    free(job_list);
+    free(pids);
+    return CUE_SUCCESS;
+}
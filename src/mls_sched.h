@@ -0,0 +1,35 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_SCHED_H__
+#define __TEST_MLS_SCHED_H__
+#include <CUnit/CUnit.h>
+
+#define SCHED_MAX_FAILS 8
+
+struct sched_failure {
+    unsigned int line;
+    char file[64];
+    char cond[192];
+};
+
+struct sched_result {
+    int done;                   // a worker ran this test
+    int worker;                 // which worker ran it
+    int init_failed;            // the suite initialization failed
+    unsigned int asserts;       // asserts evaluated
+    unsigned int asserts_failed;
+    unsigned int nfail;         // failure records kept (at most SCHED_MAX_FAILS)
+    struct sched_failure fail[SCHED_MAX_FAILS];
+};
+
+int sched_jobs(const char *arg);
+CU_ErrorCode run_parallel(int jobs);
+
+#endif
@@ -10,10 +10,11 @@
 #ifndef __TEST_MLS_SEM_H__
 #define __TEST_MLS_SEM_H__
 #include <CUnit/CUnit.h>
+#include "mls_matrix.h"
 
 int test_sem_init(void);
 int test_sem_cleanup(void);
-extern CU_TestInfo sem_tests[];
+extern struct matrix_class sem_class;
 
 #endif
 
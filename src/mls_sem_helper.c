@@ -11,7 +11,6 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
-#include <getopt.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
@@ -19,10 +18,11 @@
 #include <fcntl.h>     // for the O_ constants
 #include <sys/ipc.h>
 #include <sys/sem.h>
-#include <selinux/selinux.h>
-#include <selinux/context.h> // for context-mangling functions
 #include "mls_sem.h"
 #include "mls_support.h"
+#include "mls_helper.h"
+#include "mls_wait.h"
+#include "mls_event.h"
 
 
 union semun
@@ -33,8 +33,19 @@ union semun
 };
 
 int create_sem(const char *path, int fail)
+{
+    EVENT_PHASE();
+
+    return create_sem_set(path, 1, fail);
+}
+
+/*
+ * A set of nsems semaphores, all zero
+ */
+int create_sem_set(const char *path, int nsems, int fail)
 {
     int status = 0;
+    int i;
     key_t key;
     int id = -1;
     union semun sem_union;
@@ -48,7 +59,7 @@ int create_sem(const char *path, int fail)
         exit(-1);
     }
 
-    id = semget(key, 1, IPC_CREAT | MODE_RWX);
+    id = semget(key, nsems, IPC_CREAT | MODE_RWX);
     if (id == -1) {
         perror("semget failed");
         if (!fail) exit(-1);
@@ -58,14 +69,16 @@ int create_sem(const char *path, int fail)
         if (fail) exit(-1);
     }
 
-    status = semctl(id, 0, SETVAL, sem_union);
-    if (status == -1) {
-        perror("semctl failed");
-        if (!fail) exit(-1);
-        return 0;
-    } else {
-        printf("semctl successful\n");
-        if (fail) exit(-1);
+    for (i = 0; i < nsems; i++) {
+        status = semctl(id, i, SETVAL, sem_union);
+        if (status == -1) {
+            perror("semctl failed");
+            if (!fail) exit(-1);
+            return 0;
+        } else {
+            printf("semctl successful\n");
+            if (fail) exit(-1);
+        }
     }
     printf("Initialization complete\n");
     return id;
@@ -73,8 +86,10 @@ int create_sem(const char *path, int fail)
 
 int attach_sem(int oflag, const char *path, int fail)
 {
+    EVENT_PHASE();
     int status = 0;
-    int i = 0;
+    struct deadline dl;
+    int err;
     int id = -1;
     char *smode = (oflag == O_RDONLY) ? "read" : "write";
     int mode = (oflag == O_RDONLY) ? MODE_R : MODE_W;
@@ -88,15 +103,12 @@ int attach_sem(int oflag, const char *path, int fail)
         exit(-1);
     }
 
-    while ((i < MAX_TRIES) && (id < 0)) {
-        id = semget(key, 1, mode);
-        i++;
-
-        if (id < 0) {
-            perror("semget failed");
-            printf("Waiting %d seconds to try again.\n", WAIT_TIME);
-            sleep(WAIT_TIME);
-        }
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    while ((id = semget(key, 1, mode)) < 0) {
+        err = errno;
+        perror("semget failed");
+        // only a missing object is worth waiting for
+        if (err != ENOENT || !wait_retry(&dl)) break;
     }
 
     if (id < 0) {
@@ -112,6 +124,7 @@ int attach_sem(int oflag, const char *path, int fail)
 
 int close_sem(const char *path, int fail)
 {
+    EVENT_PHASE();
     int status = 0;
     key_t key;
     int id = -1;
@@ -148,6 +161,7 @@ int close_sem(const char *path, int fail)
 
 int write_sem(int id, const char* data, int fail)
 {
+    EVENT_PHASE();
     int status = -1;
     union semun sem_union;
     sem_union.val = atoi(data);
@@ -168,6 +182,7 @@ int write_sem(int id, const char* data, int fail)
 
 int read_sem(int id, const char* data, int fail)
 {
+    EVENT_PHASE();
     int status = -1;
     int val = atoi(data);
 
@@ -191,87 +206,16 @@ int read_sem(int id, const char* data, int fail)
 
 
 /*****************************************************************************
- * Main
+ * Driver
  */
 
-int main(int argc, char* argv[])
+int sem_helper(const struct helper_args *args)
 {
-    context_t ctx = NULL;
-    security_context_t ctx_check = NULL;
-    int opt, option_index;
-    int test_num = -1;
-    int level = -1;
     int fd = -1;
-    char *path = NULL;
-    char *log_path = NULL;
-    char *data = NULL;
-    time_t t;
-
-    static struct option long_options[] = {
-      {"output",  required_argument, 0, 'o'},
-      {"test",    required_argument, 0, 't'},
-      {"file",    required_argument, 0, 'f'},
-      {"data",    required_argument, 0, 'd'},
-      {0, 0, 0, 0}
-    };
-
-    while ((opt = getopt_long(argc, argv, "o:t:f:d:",
-                              long_options, &option_index)) != -1)
-    {
-        switch (opt) {            
-            case 'o':
-                log_path = optarg;
-                if (freopen(log_path, "a+", stdout) == NULL) {
-                    exit(-1);
-                }
-                if (freopen(log_path, "a+", stderr) == NULL) {
-                    exit(-1);
-                }
-                break;
-            case 't':
-                test_num = atoi(optarg);
-                break;
-            case 'f':
-                path = optarg;
-                break;
-            case 'd':
-                data = optarg;
-                break;
-            default:
-                printf("bad argument.\n");
-                exit(-1);
-            }
-    }     
-
-    if (test_num == -1) {
-        printf("no test specified.\n");
-        exit(-1);
-    } else if (path == NULL) {
-        printf("no path specified.\n");
-        exit(-1);
-    }
+    char *path = args->path;
+    char *data = args->data;
 
-    time(&t);
-    printf("\n%s", ctime(&t));
-    getcon(&ctx_check);
-    printf("Context: '%s'\n", ctx_check); 
-    ctx = context_new(ctx_check);
-    const char *range = context_range_get(ctx);
-
-    if (strncmp(LVL_HIGH"-", range, sizeof(LVL_HIGH"-")-1) == 0) {
-        level = AT_HIGH;
-        printf("process is at high\n");
-    } else if (strncmp(LVL_LOW"-", range, sizeof(LVL_LOW"-")-1) == 0) {
-        level = AT_LOW;
-        printf("process is at low\n");
-    } else {
-        printf("unexpected level\n");
-        exit(-1);
-    }
-
-    fflush(stdout); fflush(stderr);
-
-    switch(test_num) {
+    switch(args->test_num) {
         case 0: 
             printf("deleting sem\n");
             close_sem(path, 0);
@@ -306,4 +250,3 @@ int main(int argc, char* argv[])
     }
     return 0;
 }
-
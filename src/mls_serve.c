@@ -0,0 +1,112 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Helper side of the agent mode: a helper started with --serve <chan>
+ * stays resident at its level and runs one command per line read from
+ * <chan>.cmd, replying with the exit status on <chan>.rep. Both FIFOs are
+ * labeled at the helper's level, so the helper never writes down.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include "mls_serve.h"
+#include "mls_support.h"
+
+
+/*
+ * Split a command line on whitespace into argv, with prog as argv[0]
+ *
+ * Returns argc
+ */
+static int split_args(const char *prog, char *line, char *argv[], int max)
+{
+    char *tok, *save = NULL;
+    int argc = 0;
+
+    argv[argc++] = (char *)prog;
+    for (tok = strtok_r(line, " \t\n", &save); tok != NULL;
+         tok = strtok_r(NULL, " \t\n", &save)) {
+        if (argc == max - 1) break;
+        argv[argc++] = tok;
+    }
+    argv[argc] = NULL;
+    return argc;
+}
+
+
+/*
+ * Run a command in a child, so a failing step can still exit() without
+ * taking down the agent. Returns the status the runner would have seen
+ * from a freshly exec'd helper.
+ */
+static int run_command(int argc, char *argv[], serve_func_t run)
+{
+    pid_t pid;
+    int status = 0;
+
+    fflush(stdout); fflush(stderr);
+    pid = fork();
+    switch (pid) {
+        case -1:
+            perror("fork failed");
+            return 255;
+        case 0:
+            exit(run(argc, argv));
+        default:
+            while (waitpid(pid, &status, 0) == -1) {
+                if (errno != EINTR) return 255;
+            }
+            if (WIFEXITED(status)) return WEXITSTATUS(status);
+            if (WIFSIGNALED(status)) return 128 + WTERMSIG(status);
+            return 255;
+    }
+}
+
+
+int serve_commands(const char *prog, const char *chan, serve_func_t run)
+{
+    char path[MAX_STRING];
+    char line[SERVE_MAX_LINE];
+    char *argv[SERVE_MAX_ARGS];
+    FILE *cmd = NULL;
+    FILE *rep = NULL;
+    int argc;
+    int served = 0;
+
+    // same open order as the runner: commands first, then replies
+    snprintf(path, sizeof(path), "%s%s", chan, SERVE_CMD_EXT);
+    cmd = fopen(path, "r");
+    if (cmd == NULL) {
+        perror("open command channel failed");
+        return -1;
+    }
+    snprintf(path, sizeof(path), "%s%s", chan, SERVE_REP_EXT);
+    rep = fopen(path, "w");
+    if (rep == NULL) {
+        perror("open reply channel failed");
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), cmd) != NULL) {
+        if (strncmp(line, SERVE_QUIT, strlen(SERVE_QUIT)) == 0) break;
+        argc = split_args(prog, line, argv, SERVE_MAX_ARGS);
+        fprintf(rep, "%d\n", run_command(argc, argv, run));
+        fflush(rep);
+        served++;
+    }
+
+    fprintf(stderr, "%s: served %d commands on %s\n", prog, served, chan);
+    fclose(cmd);
+    fclose(rep);
+    return 0;
+}
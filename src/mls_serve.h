@@ -0,0 +1,24 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_SERVE_H__
+#define __TEST_MLS_SERVE_H__
+
+#define SERVE_OPT      "--serve"
+#define SERVE_CMD_EXT  ".cmd"
+#define SERVE_REP_EXT  ".rep"
+#define SERVE_QUIT     "quit"
+#define SERVE_MAX_LINE 4096
+#define SERVE_MAX_ARGS 32
+
+typedef int (*serve_func_t)(int argc, char *argv[]);
+
+int serve_commands(const char *prog, const char *chan, serve_func_t run);
+
+#endif
@@ -10,11 +10,12 @@
 #ifndef __TEST_MLS_SHM_H__
 #define __TEST_MLS_SHM_H__
 #include <CUnit/CUnit.h>
+#include "mls_matrix.h"
 
 int test_shm_init(void);
 int test_shm_cleanup(void);
-extern CU_TestInfo shm_tests[];
-extern CU_TestInfo shm_v_tests[];
+extern struct matrix_class shm_class;
+extern struct matrix_class shm_v_class;
 
 #endif
 
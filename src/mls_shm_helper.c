@@ -11,7 +11,6 @@
 #include <stdlib.h>
 #include <unistd.h>
 #include <assert.h>
-#include <getopt.h>
 #include <string.h>
 #include <errno.h>
 #include <time.h>
@@ -19,17 +18,63 @@
 #include <fcntl.h>     // for the O_ constants
 #include <sys/ipc.h>
 #include <sys/shm.h>
-#include <selinux/selinux.h>
-#include <selinux/context.h> // for context-mangling functions
 #include "mls_shm.h"
 #include "mls_support.h"
+#include "mls_helper.h"
+#include "mls_wait.h"
+#include "mls_event.h"
 
 /*****************************************************************************
  * System V shared memory logic
  */
 
 
+/*
+ * Apply the options that are not part of creating or mapping a segment:
+ * transparent huge pages for a POSIX segment, which cannot be hugetlb on
+ * tmpfs; prefaulting a System V one, as shmat() has no populate flag; and
+ * locking either.
+ */
+static void seg_options(void *p, size_t size, int opts, int system_v,
+                        int prot, int fail)
+{
+    volatile char *c = p;
+    size_t i;
+
+    if ((opts & SEG_HUGE) && !system_v) {
+        if (madvise(p, size, MADV_HUGEPAGE) != 0) {
+            perror("madvise(MADV_HUGEPAGE) failed");
+        }
+    }
+    if ((opts & SEG_POPULATE) && system_v) {
+#ifdef MADV_POPULATE_READ
+        if (madvise(p, size, (prot & PROT_WRITE) ? MADV_POPULATE_WRITE
+                                                 : MADV_POPULATE_READ) != 0)
+#endif
+        {
+            for (i = 0; i < size; i += sysconf(_SC_PAGESIZE)) (void)c[i];
+        }
+    }
+    if (opts & SEG_LOCK) {
+        if (mlock(p, size) != 0) {
+            perror("mlock failed");
+            if (!fail) exit(-1);
+        } else {
+            printf("mlock successful\n");
+        }
+    }
+}
+
+
 int create_shm_v(struct shared_space_t **ptr, const char *path, int fail)
+{
+    EVENT_PHASE();
+
+    return create_shm_v_sized(ptr, path, MEM_SIZE, 0, fail);
+}
+
+int create_shm_v_sized(struct shared_space_t **ptr, const char *path,
+                       size_t size, int opts, int fail)
 {
     int status = 0;
     key_t key;
@@ -44,7 +89,8 @@ int create_shm_v(struct shared_space_t **ptr, const char *path, int fail)
         exit(-1);
     }
 
-    id = shmget(key, MEM_SIZE, IPC_CREAT | MODE_RWX);
+    id = shmget(key, size, IPC_CREAT | MODE_RWX |
+                ((opts & SEG_HUGE) ? SHM_HUGETLB : 0));
     if (id == -1) {
         perror("shmget failed");
         if (!fail) exit(-1);
@@ -63,11 +109,13 @@ int create_shm_v(struct shared_space_t **ptr, const char *path, int fail)
         printf("shmat successful\n");
         if (fail) exit(-1);
     }
+    seg_options(segptr, size, opts, 1, PROT_READ | PROT_WRITE, fail);
 
     // Initialize the data structure in memory
     segptr->counter = 0;
+    segptr->written_ns = 0;
     memset(segptr->data, 0, MAX_STRING);
-    segptr->state = STATE_READY;
+    __atomic_store_n(&segptr->state, STATE_READY, __ATOMIC_RELEASE);
     printf("Initialization complete\n");
     *ptr = segptr;
     return id;
@@ -75,10 +123,19 @@ int create_shm_v(struct shared_space_t **ptr, const char *path, int fail)
 
 int attach_shm_v(int oflag, struct shared_space_t **ptr, 
                  const char *path, int fail)
+{
+    EVENT_PHASE();
+
+    return attach_shm_v_sized(oflag, ptr, path, MEM_SIZE, 0, fail);
+}
+
+int attach_shm_v_sized(int oflag, struct shared_space_t **ptr,
+                       const char *path, size_t size, int opts, int fail)
 {
     struct shared_space_t *segptr = NULL;
     int status = 0;
-    int i = 0;
+    struct deadline dl;
+    int err;
     int id = -1;
     char * smode = (oflag == O_RDONLY) ? "read" : "write";
     mode_t mode = (oflag == O_RDONLY) ? SHM_R : SHM_W;
@@ -93,15 +150,12 @@ int attach_shm_v(int oflag, struct shared_space_t **ptr,
         exit(-1);
     }
 
-    while ((i < MAX_TRIES) && (id < 0)) {
-        id = shmget(key, MEM_SIZE, mode);
-        i++;
-
-        if (id < 0) {
-            perror("shmget failed");
-            printf("Waiting %d seconds to try again.\n", WAIT_TIME);
-            sleep(WAIT_TIME);
-        }
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    while ((id = shmget(key, MEM_SIZE, mode)) < 0) {
+        err = errno;
+        perror("shmget failed");
+        // only a missing object is worth waiting for
+        if (err != ENOENT || !wait_retry(&dl)) break;
     }
 
     if (id < 0) {
@@ -121,6 +175,8 @@ int attach_shm_v(int oflag, struct shared_space_t **ptr,
     } else {
         printf("shmat successful\n");
         if (fail) exit(-1);
+        seg_options(segptr, size, opts, 1,
+                    (oflag == O_RDONLY) ? PROT_READ : PROT_WRITE, fail);
         *ptr = segptr;
     }
 
@@ -129,6 +185,7 @@ int attach_shm_v(int oflag, struct shared_space_t **ptr,
 
 int close_shm_v(const char *path)
 {
+    EVENT_PHASE();
     int status = 0;
     key_t key;
     void *segptr = NULL;
@@ -188,6 +245,14 @@ int close_shm_v(const char *path)
 
 
 int create_shm(struct shared_space_t **ptr, const char *path, int fail)
+{
+    EVENT_PHASE();
+
+    return create_shm_sized(ptr, path, MEM_SIZE, 0, fail);
+}
+
+int create_shm_sized(struct shared_space_t **ptr, const char *path,
+                     size_t size, int opts, int fail)
 {
     struct shared_space_t *segptr = NULL;
     int status= 0;
@@ -206,7 +271,7 @@ int create_shm(struct shared_space_t **ptr, const char *path, int fail)
     }
 
     // Set the size of the shared memory object
-    status = ftruncate(fd, MEM_SIZE);
+    status = ftruncate(fd, size);
     if (status != 0) {
         perror("ftruncate failed");
         if (!fail) exit(-1);
@@ -217,19 +282,22 @@ int create_shm(struct shared_space_t **ptr, const char *path, int fail)
 
     // Map the object into the process memory space
     segptr = (struct shared_space_t *) 
-        mmap(NULL, MEM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED |
+             ((opts & SEG_POPULATE) ? MAP_POPULATE : 0), fd, 0);
     if (segptr == MAP_FAILED) {
         perror("mmap failed");
         if (!fail) exit(-1);
     } else {
         printf("mmap successful\n");
         if (fail) exit(-1);
+        seg_options(segptr, size, opts, 0, PROT_READ | PROT_WRITE, fail);
     }
 
     // Initialize the data structure in memory
     segptr->counter = 0;
+    segptr->written_ns = 0;
     memset(segptr->data, 0, MAX_STRING);
-    segptr->state = STATE_READY;
+    __atomic_store_n(&segptr->state, STATE_READY, __ATOMIC_RELEASE);
     printf("Initialization complete\n");
     *ptr = segptr;
     return fd;
@@ -238,10 +306,19 @@ int create_shm(struct shared_space_t **ptr, const char *path, int fail)
 
 int attach_shm(int oflag, struct shared_space_t **ptr, 
                const char *path, int fail)
+{
+    EVENT_PHASE();
+
+    return attach_shm_sized(oflag, ptr, path, MEM_SIZE, 0, fail);
+}
+
+int attach_shm_sized(int oflag, struct shared_space_t **ptr,
+                     const char *path, size_t size, int opts, int fail)
 {
     struct shared_space_t *segptr = NULL;
     int status= 0;
-    int i = 0;
+    struct deadline dl;
+    int err;
     int fd = -1;
     char * smode = (oflag == O_RDONLY) ? "read" : "write";
     int prot = (oflag == O_RDONLY) ? PROT_READ : PROT_WRITE;
@@ -249,15 +326,12 @@ int attach_shm(int oflag, struct shared_space_t **ptr,
 
     printf("%s(%s, ..., %s)\n", __func__, smode, path);
 
-    while ((i < MAX_TRIES) && (fd < 0)) {
-        fd = shm_open(path, oflag, mode);
-        i++;
-
-        if (fd < 0) {
-            perror("shm_open failed");
-            printf("Waiting %d seconds to try again.\n", WAIT_TIME);
-            sleep(WAIT_TIME);
-        }
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    while ((fd = shm_open(path, oflag, mode)) < 0) {
+        err = errno;
+        perror("shm_open failed");
+        // only a missing object is worth waiting for
+        if (err != ENOENT || !wait_shm_created(path, &dl)) break;
     }
 
     if (fd < 0) {
@@ -271,13 +345,15 @@ int attach_shm(int oflag, struct shared_space_t **ptr,
 
     // Map the object into the process memory space
     segptr = (struct shared_space_t *) 
-        mmap(NULL, MEM_SIZE, prot, MAP_SHARED, fd, 0);
+        mmap(NULL, size, prot, MAP_SHARED |
+             ((opts & SEG_POPULATE) ? MAP_POPULATE : 0), fd, 0);
     if (segptr == MAP_FAILED) {
         perror("mmap failed");
         if (!fail) exit(-1);
     } else {
         printf("mmap successful\n");
         if (fail) exit(-1);
+        seg_options(segptr, size, opts, 0, prot, fail);
         *ptr = segptr;
     }
 
@@ -287,6 +363,7 @@ int attach_shm(int oflag, struct shared_space_t **ptr,
 
 int close_shm(const char *path)
 {
+    EVENT_PHASE();
     int status= 0;
 
     printf("%s(..., %s)\n", __func__, path);
@@ -305,6 +382,7 @@ int close_shm(const char *path)
 
 int write_shm(struct shared_space_t *segptr, const char* data, int fail)
 {
+    EVENT_PHASE();
     char *status = NULL;
 
     printf("%s(..., %s)\n", __func__, data);
@@ -316,7 +394,7 @@ int write_shm(struct shared_space_t *segptr, const char* data, int fail)
     printf("State of shm (%d: %s)\n", segptr->counter, segptr->data);
     
     // Pass data
-    segptr->state = STATE_WRITING;
+    __atomic_store_n(&segptr->state, STATE_WRITING, __ATOMIC_RELAXED);
     status = strcpy(segptr->data, data);
 
     if (segptr->data != status) {
@@ -328,8 +406,11 @@ int write_shm(struct shared_space_t *segptr, const char* data, int fail)
         if (fail) exit(-1);
     }
 
-    segptr->counter = ++(segptr->counter);
-    segptr->state = STATE_DONE;
+    // Publish: the release store orders the contents before the state
+    __atomic_add_fetch(&segptr->counter, 1, __ATOMIC_RELAXED);
+    segptr->written_ns = monotonic_ns();
+    __atomic_store_n(&segptr->state, STATE_DONE, __ATOMIC_RELEASE);
+    futex_wake_all(&segptr->state);
     printf("State of shm (%d: %s)\n", segptr->counter, segptr->data);
     return 0;
 }
@@ -337,9 +418,13 @@ int write_shm(struct shared_space_t *segptr, const char* data, int fail)
 
 int read_shm(struct shared_space_t *segptr, const char* data, int fail)
 {
+    EVENT_PHASE();
+    struct deadline dl;
+    unsigned int state;
+    unsigned int last = 0;
+    unsigned long long now;
+    unsigned long long parked = 0;      // when the last wait began
     int status;
-    int done = 0;
-    int tries = 0;
 
     printf("%s(..., %s)\n", __func__, data);
 
@@ -348,129 +433,68 @@ int read_shm(struct shared_space_t *segptr, const char* data, int fail)
         return 0;
     }
 
-    while ((tries <= MAX_TRIES) && (!done)) {
-        switch (segptr->state) {
-            case STATE_DONE:
-                status = strncmp(segptr->data, data, strlen(data));
-                printf("State of shm (%d: %s)\n",
-                       segptr->counter, segptr->data);
-                if (status != 0) {
-                    printf("Data did not look as expected");
+    deadline_init(&dl, WAIT_DEADLINE_MS);
+    while ((state = __atomic_load_n(&segptr->state, __ATOMIC_ACQUIRE))
+           != STATE_DONE) {
+        if (state != last) {
+            switch (state) {
+                case STATE_READY:
+                    printf("Creator has not yet written.\n");
+                    break;
+                case STATE_WRITING:
+                    printf("Creator is writing.\n");
+                    break;
+                default:
+                    printf("Corrupted segment state: exiting\n");
                     exit(-1);
-                }
-                done = 1;
-                break;
-            case STATE_READY:
-                printf("Creator has not yet written.\n");
-                break;
-            case STATE_WRITING:
-                printf("Creator is writing.\n");
-                break;
-            default:
-                printf("Corrupted segment state: exiting\n");
-                exit(-1);
-                break;
+                    break;
+            }
+            last = state;
+        }
+        parked = monotonic_ns();
+        if (!futex_wait_change(&segptr->state, state, &dl)) {
+            printf("Giving up.\n");
+            if (!fail) exit(-1);
+            return 0;
         }
-        sleep(WAIT_TIME);
-        ++tries;
     }
-    if (tries > MAX_TRIES) {
-        printf("Giving up.\n");
-        if (!fail) exit(-1);
+
+    now = monotonic_ns();
+    status = strncmp(segptr->data, data, strlen(data));
+    printf("State of shm (%d: %s)\n", segptr->counter, segptr->data);
+    if (status != 0) {
+        printf("Data did not look as expected");
+        exit(-1);
+    }
+    // a reader that came after the write would time its own launch
+    if (parked != 0 && parked < segptr->written_ns) {
+        printf("Handoff latency: %.1f us\n",
+               (now - segptr->written_ns) / 1000.0);
+        event_phase_add("handoff", segptr->written_ns, now);
+    } else {
+        printf("No handoff: written before the reader waited\n");
     }
     return 0;
 }
 
 
 /*****************************************************************************
- * Main
+ * Driver
  */
 
-int main(int argc, char* argv[])
+int shm_helper(const struct helper_args *args)
 {
-    context_t ctx = NULL;
-    security_context_t ctx_check = NULL;
     struct shared_space_t *segptr;
-    int opt, option_index;
-    int test_num = -1;
-    int level = -1;
     int fd = -1;
-    int system_v = 0;
-    char *path = NULL;
-    char *log_path = NULL;
-    char *data = NULL;
-    time_t t;
-
-    static struct option long_options[] = {
-      {"output",  required_argument, 0, 'o'},
-      {"test",    required_argument, 0, 't'},
-      {"file",    required_argument, 0, 'f'},
-      {"data",    required_argument, 0, 'd'},
-      {"sysv",    no_argument,       0, 'v'},
-      {0, 0, 0, 0}
-    };
-
-    while ((opt = getopt_long(argc, argv, "o:t:f:d:v",
-                              long_options, &option_index)) != -1)
-    {
-        switch (opt) {            
-            case 'o':
-                log_path = optarg;
-                if (freopen(log_path, "a+", stdout) == NULL) {
-                    exit(-1);
-                }
-                if (freopen(log_path, "a+", stderr) == NULL) {
-                    exit(-1);
-                }
-                break;
-            case 't':
-                test_num = atoi(optarg);
-                break;
-            case 'f':
-                path = optarg;
-                break;
-            case 'd':
-                data = optarg;
-                break;
-            case 'v':
-                system_v = 1;
-                printf("using System V shm.\n");
-                break;
-            default:
-                printf("bad argument.\n");
-                exit(-1);
-            }
-    }     
-
-    if (test_num == -1) {
-        printf("no test specified.\n");
-        exit(-1);
-    } else if (path == NULL) {
-        printf("no path specified.\n");
-        exit(-1);
-    }
+    int system_v = args->system_v;
+    char *path = args->path;
+    char *data = args->data;
 
-    time(&t);
-    printf("\n%s", ctime(&t));
-    getcon(&ctx_check);
-    printf("Context: '%s'\n", ctx_check); 
-    ctx = context_new(ctx_check);
-    const char *range = context_range_get(ctx);
-
-    if (strncmp(LVL_HIGH"-", range, sizeof(LVL_HIGH"-")-1) == 0) {
-        level = AT_HIGH;
-        printf("process is at high\n");
-    } else if (strncmp(LVL_LOW"-", range, sizeof(LVL_LOW"-")-1) == 0) {
-        level = AT_LOW;
-        printf("process is at low\n");
-    } else {
-        printf("unexpected level\n");
-        exit(-1);
+    if (system_v) {
+        printf("using System V shm.\n");
     }
 
-    fflush(stdout); fflush(stderr);
-
-    switch(test_num) {
+    switch(args->test_num) {
         case 0: 
             printf("deleting shm\n");
             if (system_v) {
@@ -490,6 +514,15 @@ int main(int argc, char* argv[])
                 if (fd > -1) close(fd);
             }
             break;
+        case 6:
+            printf("creating shm, leaving it unwritten\n");
+            if (system_v) {
+                create_shm_v(&segptr, path, 0);
+            } else {
+                fd = create_shm(&segptr, path, 0);
+                if (fd > -1) close(fd);
+            }
+            break;
         case 2:
             printf("attaching and reading shm\n");
             if (system_v) {
@@ -537,4 +570,3 @@ int main(int argc, char* argv[])
     }
     return 0;
 }
-
@@ -8,216 +8,127 @@
  */
 #include <stdlib.h>
 #include <stdio.h>
-#include <errno.h>
+#include <unistd.h>
 #include <string.h>
+#include <time.h>
 #include <sys/types.h>
-#include <sys/stat.h>
 #include <selinux/selinux.h>
-#include <selinux/context.h> // for context-mangling functions
 #include <CUnit/CUnit.h>
 #include "mls_support.h"
+#include "mls_agent.h"
+#include "mls_child.h"
+#include "mls_event.h"
+#include "mls_report.h"
+#include "mls_phase.h"
 
-/**
- * Construct from the current range and specified desired level a resulting
- * range. If the specified level is a range, return that. If it is not, then
- * construct a range with level as the sensitivity and clearance of the current
- * context.
- *
- * newlevel - the level specified on the command line
- * range    - the range in the current context
+int mls_worker = -1;
+static char log_low_path[MAX_STRING] = "log/low_log.txt";
+static char log_high_path[MAX_STRING] = "log/high_log.txt";
+char *log_paths[2] = { log_low_path, log_high_path };
+
+/*
+ * Derive the name of a per-worker object (shm segment, log file, fixture)
+ * from its serial name, so that concurrent workers never share an object.
+ * When running serially the name is used unchanged. The worker tag goes
+ * before the file extension, if there is one.
  *
- * Returns malloc'd memory
+ * Returns buf
  */
-char *build_new_range(const char *newlevel, const char *range)
+char *worker_name(char *buf, size_t len, const char *name)
 {
-    char *newrangep = NULL;
-    const char *tmpptr;
-    size_t len;
+    const char *ext;
+    const char *base;
 
-    // a missing or empty string
-    if (!range || !strlen(range) || !newlevel || !strlen(newlevel))
-        return NULL;
-
-    // if the newlevel is actually a range - just use that
-    if (strchr(newlevel, '-')) {
-        newrangep = strdup(newlevel);
-        return newrangep;
+    if (mls_worker < 0) {
+        snprintf(buf, len, "%s", name);
+        return buf;
     }
 
-    // look for MLS range in current context
-    tmpptr = strchr(range, '-');
-    if (tmpptr) {
-        /* we are inserting into a ranged MLS context */
-        len = strlen(newlevel) + 1 + strlen(tmpptr + 1) + 1;
-        newrangep = (char *)malloc(len);
-        if (!newrangep)
-            return NULL;
-        snprintf(newrangep, len, "%s-%s", newlevel, tmpptr + 1);
+    base = strrchr(name, '/');
+    base = base ? base + 1 : name;
+    ext = strrchr(base, '.');
+    if (ext == NULL || ext == base) {
+        snprintf(buf, len, "%s.w%d", name, mls_worker);
     } else {
-        // we are inserting into a currently non-ranged MLS context
-        if (!strcmp(newlevel, range)) {
-            newrangep = strdup(range);
-        } else {
-            len = strlen(newlevel) + 1 + strlen(range) + 1;
-            newrangep = (char *)malloc(len);
-            if (!newrangep)
-                return NULL;
-            snprintf(newrangep, len, "%s-%s", newlevel, range);
-        }
+        snprintf(buf, len, "%.*s.w%d%s", (int)(ext - name), name,
+                 mls_worker, ext);
     }
-
-    return newrangep;
+    return buf;
 }
 
-
 /*
- * Change context to a new level
+ * Derive the path handed to ftok() for a System V object. Serially this is
+ * the path itself; a worker gets its own anchor file under files/, created
+ * at the system low level so processes at any level can stat it.
+ *
+ * Returns buf, or NULL if the anchor could not be created
  */
-void chcon_to_level(const char *level_s)
+char *worker_key_path(char *buf, size_t len, const char *path)
 {
-    security_context_t new_ctx = NULL;
-    security_context_t old_ctx = NULL;
-    context_t ctx = NULL;
-    char *new_range = NULL;
-    int status = 0;
+    char *p;
 
-    // Build new context, from old context
-    status = getcon(&old_ctx);
-    CU_ASSERT_EQUAL(status, 0);
-    fprintf(stderr, "Current process context: '%s'\n", old_ctx);
-    
-    ctx = context_new(old_ctx);
-    CU_ASSERT_PTR_NOT_NULL(ctx);
-    
-    new_range = build_new_range(level_s, context_range_get(ctx));
-    CU_ASSERT_PTR_NOT_NULL(new_range);
-    status = context_range_set(ctx, new_range);
-    CU_ASSERT_EQUAL(status, 0);
-    
-    // Change new context to user_u equivalent
-    status = context_user_set(ctx, "mls_test_u");
-    CU_ASSERT_EQUAL(status, 0);
-    status = context_role_set(ctx, "user_r");
-    CU_ASSERT_EQUAL(status, 0);
-    status = context_type_set(ctx, "user_t");
-    CU_ASSERT_EQUAL(status, 0);
-    
-    fprintf(stderr, "New range: %s\n", context_range_get(ctx));
-    new_ctx = context_str(ctx);     
-    fprintf(stderr, "New process context: '%s'\n", new_ctx);
-    CU_ASSERT_PTR_NOT_NULL(new_ctx);
-
-    // change context for exec
-    status = setexeccon(new_ctx);
-    CU_ASSERT_EQUAL(status, 0);
+    if (mls_worker < 0) {
+        snprintf(buf, len, "%s", path);
+        return buf;
+    }
 
-    freecon(new_ctx);
-    freecon(old_ctx);
-    free(new_range);
+    snprintf(buf, len, "files/ftok%s.w%d", path, mls_worker);
+    for (p = buf + strlen("files/ftok"); *p; p++) {
+        if (*p == '/') *p = '_';
+    }
+    if (create_file(LVL_SYSLOW, buf, NULL) != 0) {
+        return NULL;
+    }
+    return buf;
 }
 
-
 /*
- * Create a file at a new level
+ * Called in a freshly forked scheduler worker, before any suite runs
  */
-int create_file(const char *lvl, const char *path, const char *data)
+void worker_setup(int worker)
 {
-    security_context_t new_ctx = NULL;
-    security_context_t old_ctx = NULL;
-    context_t ctx = NULL;
-    char *new_range = NULL;
-    int status = 0;
-    FILE *file = NULL;
-
-    status = getcon(&old_ctx);
-    if (status != 0) return -1;
-    ctx = context_new(old_ctx);
-    if (ctx == NULL) return -1;
-
-    new_range = build_new_range(lvl, context_range_get(ctx));
-    if (new_range == NULL) return -1;
-    status = context_range_set(ctx, new_range);
-    if (status != 0) return -1;
-
-    status = context_user_set(ctx, "mls_test_u");
-    if (status != 0) return -1;
-    status = context_role_set(ctx, "object_r");
-    if (status != 0) return -1;
-    status = context_type_set(ctx, "user_home_t");
-    if (status != 0) return -1;
-
-    new_ctx = context_str(ctx);
-    fprintf(stderr, "writing file '%s' with context '%s'\n", path, new_ctx);
-    if (ctx == NULL) return -1;
-    status = setfscreatecon(new_ctx);
-    if (status != 0) return -1;
-
-    file = fopen(path, "a+");
-    if (file == NULL) {
-        perror("fopen failed");
-        return -1;
-    }
-    fprintf(stderr, "opened file '%s' with context '%s'\n", path, new_ctx);
-
-    if (data != NULL) {
-        status = fprintf(file, "%s", data);
-        if (status != strlen(data)) {
-            fprintf(stderr, "fprintf(): %d (%s)\n", errno, strerror(errno));
-            return -1;
-        }
-    }
-    fclose(file);
-    freecon(new_ctx);
-    freecon(old_ctx);
-    free(new_range);
-    return 0;
+    mls_worker = worker;
+    worker_name(log_low_path, sizeof(log_low_path), "log/low_log.txt");
+    worker_name(log_high_path, sizeof(log_high_path), "log/high_log.txt");
 }
 
 /*
- * Create a FIFO at a new level
+ * Set the exec context to a process context from the cache
  */
-int create_fifo(const char *lvl, const char *path)
+void chcon_to_context(const struct level_context *c)
 {
-    security_context_t new_ctx = NULL;
-    security_context_t old_ctx = NULL;
-    context_t ctx = NULL;
-    char *new_range = NULL;
     int status = 0;
 
-    status = getcon(&old_ctx);
-    if (status != 0) return -1;
-    ctx = context_new(old_ctx);
-    if (ctx == NULL) return -1;
+    CU_ASSERT_PTR_NOT_NULL(c);
+    if (c == NULL) return;
+    fprintf(stderr, "New process context: '%s'\n", c->proc);
 
-    new_range = build_new_range(lvl, context_range_get(ctx));
-    if (new_range == NULL) return -1;
-    status = context_range_set(ctx, new_range);
-    if (status != 0) return -1;
+    // change context for exec
+    status = setexeccon(c->proc);
+    CU_ASSERT_EQUAL(status, 0);
+}
 
-    status = context_user_set(ctx, "mls_test_u");
-    if (status != 0) return -1;
-    status = context_role_set(ctx, "object_r");
-    if (status != 0) return -1;
-    status = context_type_set(ctx, "user_home_t");
-    if (status != 0) return -1;
 
-    new_ctx = context_str(ctx);
-    fprintf(stderr, "writing file '%s' with context '%s'\n", path, new_ctx);
-    if (ctx == NULL) return -1;
-    status = setfscreatecon(new_ctx);
-    if (status != 0) return -1;
+/*
+ * Change context to a new level
+ */
+void chcon_to_level(const char *level_s)
+{
+    chcon_to_context(level_context(level_s));
+}
 
-    status = mkfifo(path, S_IRWXU|S_IRWXG|S_IRWXO);
-    if (status != 0) {
-        perror("mkfifo failed");
-        return -1;
-    }
-    fprintf(stderr, "created file '%s' with context '%s'\n", path, new_ctx);
 
-    freecon(new_ctx);
-    freecon(old_ctx);
-    free(new_range);
-    return 0;
+/*
+ * An event ring for the helpers at lvl, labeled at lvl
+ */
+int create_ring(const char *lvl, const char *path)
+{
+    const struct level_context *c = level_context(lvl);
+
+    if (c == NULL) return -1;
+    fprintf(stderr, "writing ring '%s' with context '%s'\n", path, c->ring);
+    if (setfscreatecon(c->ring) != 0) return -1;
+    return event_ring_create(path);
 }
 
 /*
@@ -225,47 +136,35 @@ int create_fifo(const char *lvl, const char *path)
  */
 int fork_to_lvl(const char *lvl, char * const argv[])
 {
-    pid_t pid;
+    struct mls_child child;
+    struct timespec start, end;
+    char what[MAX_STRING];
+    size_t len = 0;
     int status = 0;
     int i;
 
-    pid = fork();
-    switch(pid) 
-    {
-        case -1:
-            perror("fork failed");
-            break;
-        case 0:
-            chcon_to_level(lvl);
-            fprintf(stderr, "Running: ");
-            for(i=0; argv[i] != NULL; i++) {
-                fprintf(stderr, "%s ", argv[i]);
-            }
-            fprintf(stderr, "\n");
-            execvp(argv[0], argv);
-            fprintf(stderr, "got past exec()\n");
-            perror("exec failed");
-            CU_FAIL("got past exec");
-            exit(-1);
-            break;
-        default:
-            fprintf(stderr, "child pid is %i\n", pid);
-            do {
-                pid = waitpid(pid, &status, 0);
-            } while (pid == -1);
-            if (WIFEXITED(status)) {
-                fprintf(stderr, "child %d exited with status %d\n", pid,
-                        WEXITSTATUS(status));
-                CU_ASSERT_EQUAL(WEXITSTATUS(status), 0);
-            } else if (WIFSIGNALED(status)) {
-                fprintf(stderr, "child %d exited from signal %d\n", pid,
-                        WTERMSIG(status));
-                CU_ASSERT(1 == 0);
-            } else {
-                fprintf(stderr, "child %d exited somehow\n", pid);
-                CU_ASSERT(1 == -1);            
-            }
-            break;
+    if (agent_mode) {
+        for (i = 0; argv[i] != NULL && len < sizeof(what); i++) {
+            len += snprintf(what + len, sizeof(what) - len, "%s%s",
+                            i ? " " : "", argv[i]);
+        }
+        clock_gettime(CLOCK_MONOTONIC, &start);
+        status = agent_run(lvl, argv);
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        fprintf(stderr, "agent step exited with status %d\n", status);
+        report_step(what, lvl, status, (end.tv_sec - start.tv_sec) +
+                    (end.tv_nsec - start.tv_nsec) / 1e9);
+        phase_add("agent", (end.tv_sec - start.tv_sec) * 1000000000ULL +
+                  (end.tv_nsec - start.tv_nsec));
+        CU_ASSERT_EQUAL(status, 0);
+        return 0;
+    }
+
+    if (child_launch(&child, lvl, argv) != 0) {
+        CU_FAIL("launch failed");
+        return 0;
     }
+    child_wait(&child);
+    child_exit_ok(&child);
     return 0;
 }
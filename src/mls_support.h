@@ -9,15 +9,17 @@
  */
 #ifndef __TEST_MLS_SUPPORT_H__
 #define __TEST_MLS_SUPPORT_H__
+#include <stddef.h>
 
 #define LVL_HIGH    "s15"
 #define LVL_LOW     "s0"
 #define LVL_SYSLOW  "s0"
 #define AT_LOW     0
 #define AT_HIGH    1
+#define AT_OTHER   2
 
-#define log_high "log/high_log.txt"
-#define log_low  "log/low_log.txt"
+#define log_high log_paths[AT_HIGH]
+#define log_low  log_paths[AT_LOW]
 
 #define LOW_CONTENTS    "abcdef"
 #define HIGH_CONTENTS   "ABCDEF"
@@ -30,10 +32,12 @@
 #define MAX_STRING 128
 #define MAX_TRIES 3
 #define WAIT_TIME 1
+#define WAIT_DEADLINE_MS (MAX_TRIES * WAIT_TIME * 1000)
 
 struct shared_space_t {
-    unsigned int state;     // Ready, Writing, Closed
+    unsigned int state;     // Ready, Writing, Done; also a futex word
     unsigned int counter;   // Version of the contents
+    unsigned long long written_ns;  // CLOCK_MONOTONIC when last published
     char data[MAX_STRING];  // Data to pass
 };
 #define MEM_SIZE (sizeof(struct shared_space_t))
@@ -42,10 +46,39 @@ struct shared_space_t {
 #define STATE_WRITING 2
 #define STATE_DONE    3
 
+#define MAX_LEVELS 64
+
+struct level_context {
+    char lvl[MAX_STRING];
+    char *proc;             // process context, for setexeccon()
+    char *file;             // object context, for setfscreatecon()
+    char *ring;             // the same, typed for an event ring
+};
+
+/* Context cache counters, merged over the workers */
+struct context_stats {
+    unsigned int built;         // contexts built by workers, after the init
+    unsigned int reused;
+};
+
+extern int mls_worker;
+extern char *log_paths[2];
+
+char *worker_name(char *buf, size_t len, const char *name);
+char *worker_key_path(char *buf, size_t len, const char *path);
+void worker_setup(int worker);
 
 char *build_new_range(const char *newlevel, const char *range);
+const struct level_context *level_context(const char *lvl);
+int context_cache_init(void);
+void context_report(void);
+void context_merge(struct context_stats *to);
+void context_adopt(const struct context_stats *from);
+void chcon_to_context(const struct level_context *c);
 void chcon_to_level(const char *level_s);
 int create_file(const char *lvl, const char *path, const char *data);
+int create_fifo(const char *lvl, const char *path);
+int create_ring(const char *lvl, const char *path);
 int fork_to_lvl(const char *lvl, char * const argv[]);
 
 #endif
@@ -8,6 +8,9 @@
  *            See http://opensource.org/licenses/BSD-2-Clause
  */
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
 #include <sys/types.h>
 #include <sys/wait.h>
 #include <CUnit/Basic.h>
@@ -16,20 +19,131 @@
 #include "mls_msg.h"
 #include "mls_sem.h"
 #include "mls_pipe.h"
+#include "mls_sched.h"
+#include "mls_agent.h"
+#include "mls_child.h"
+#include "mls_support.h"
+#include "mls_matrix.h"
+#include "mls_event.h"
+#include "mls_report.h"
+#include "mls_phase.h"
+#include "mls_cats.h"
+#include "mls_oracle.h"
+#include "mls_avc.h"
 
-int main(void)
+static void usage(const char *prog)
 {
+    fprintf(stderr, "usage: %s [-a] [-c] [-s] [-j jobs] [-l secs] [-m MB] "
+                    "[-p pct]\n"
+                    "       [-J junit.xml] [-T report.tap]\n", prog);
+    fprintf(stderr, "  -a        keep one resident helper per level "
+                    "instead of exec'ing one per step\n");
+    fprintf(stderr, "  -c        check category sets: a pairwise sample "
+                    "of equal, dominated and\n"
+                    "            incomparable labels\n");
+    fprintf(stderr, "  -j jobs   run tests on a pool of workers "
+                    "(0 = one per cpu)\n");
+    fprintf(stderr, "  -J file   stream results as JUnit XML, one file per "
+                    "worker with -j\n");
+    fprintf(stderr, "  -l secs   check the s0..s15 ladder, best pairs "
+                    "first, in about secs seconds\n");
+    fprintf(stderr, "  -p pct    ask the policy for every cell and confirm "
+                    "pct%% of them with helpers\n");
+    fprintf(stderr, "  -s        launch helpers with posix_spawn "
+                    "instead of fork\n");
+    fprintf(stderr, "  -T file   stream results as TAP, one file per "
+                    "worker with -j\n");
+    fprintf(stderr, "  -m MB     grow the runner by MB of touched memory, "
+                    "to compare launch paths\n");
+    exit(-1);
+}
+
+int main(int argc, char *argv[])
+{
+    int jobs = 1;
+    int ladder = 0;
+    int cats = 0;
+    size_t ballast = 0;
+    char *ballast_mem = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "acj:l:m:p:sJ:T:")) != -1) {
+        switch (opt) {
+            case 'a':
+                agent_mode = 1;
+                break;
+            case 'c':
+                cats = 1;
+                break;
+            case 'j':
+                jobs = sched_jobs(optarg);
+                break;
+            case 'l':
+                ladder = atoi(optarg);
+                if (ladder <= 0) usage(argv[0]);
+                break;
+            case 'm':
+                ballast = (size_t)atoi(optarg) << 20;
+                break;
+            case 'p':
+                avc_confirm = atoi(optarg);
+                if (avc_confirm < 0 || avc_confirm > 100) usage(argv[0]);
+                break;
+            case 's':
+                launch_mode = LAUNCH_SPAWN;
+                break;
+            case 'J':
+                report_junit = optarg;
+                break;
+            case 'T':
+                report_tap = optarg;
+                break;
+            default:
+                usage(argv[0]);
+        }
+    }
+
+    if (cats && ladder) {
+        usage(argv[0]);
+    } else if (ladder) {
+        matrix_ladder(ladder);
+    } else if (cats && cats_generate() < 0) {
+        fprintf(stderr, "too many category cases\n");
+        return -1;
+    }
+
+    if (ballast > 0) {
+        ballast_mem = malloc(ballast);
+        if (ballast_mem == NULL) {
+            perror("malloc failed");
+            return -1;
+        }
+        memset(ballast_mem, 1, ballast);
+    }
+
+    if (context_cache_init() != 0) {
+        fprintf(stderr, "could not build the test contexts\n");
+        return -1;
+    }
+
+    if (avc_confirm >= 0 && avc_precheck_init() != 0) {
+        return -1;
+    }
+
     if (CU_initialize_registry() != CUE_SUCCESS)
         return CU_get_error();
 
     // Add suites to registry
     CU_SuiteInfo suites[] = {
-      {"file", test_file_init, test_file_cleanup, file_tests},
-      {"posix shm", test_shm_init, test_shm_cleanup, shm_tests},
-      {"sys v shm", test_shm_init, test_shm_cleanup, shm_v_tests},
-      {"msg queue", test_msg_init, test_msg_cleanup, msg_tests},
-      {"sem", test_sem_init, test_sem_cleanup, sem_tests},
-      //{"pipes", test_pipe_init, test_pipe_cleanup, pipe_tests},
+      {.pName = "level", .pInitFunc = test_oracle_init,
+       .pCleanupFunc = test_oracle_cleanup, .pTests = oracle_tests},
+      matrix_suite(&file_class, test_file_init, test_file_cleanup),
+      matrix_suite(&shm_class, test_shm_init, test_shm_cleanup),
+      matrix_suite(&shm_v_class, test_shm_init, test_shm_cleanup),
+      matrix_suite(&msg_class, test_msg_init, test_msg_cleanup),
+      matrix_suite(&sem_class, test_sem_init, test_sem_cleanup),
+      {.pName = "pipes", .pInitFunc = test_pipe_init,
+       .pCleanupFunc = test_pipe_cleanup, .pTests = pipe_tests},
       CU_SUITE_INFO_NULL
     };
 
@@ -38,10 +152,30 @@ int main(void)
     CU_basic_set_mode(CU_BRM_VERBOSE);
     
     // Run all of the  tests
-    CU_basic_run_tests();
+    if (jobs > 1) {
+        // reports the merged counters itself, while they are still mapped
+        run_parallel(jobs);
+        // the case labels were drawn before the workers forked
+        if (cats) cats_report();
+    } else {
+        if (report_junit != NULL || report_tap != NULL) {
+            report_run();
+        } else {
+            CU_basic_run_tests();
+        }
+        agents_stop();
+        launch_report();
+        context_report();
+        matrix_report();
+        event_report();
+        phase_report();
+        if (cats) cats_report();
+    }
+    avc_precheck_stop();
 
     // Clear the test registry
     CU_cleanup_registry();
+    free(ballast_mem);
 
     // Get and then return the error code from running the tests
     return CU_get_error();
@@ -0,0 +1,177 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * Waiting for another helper's object to appear, with a real deadline.
+ * POSIX shm names are watched with inotify on /dev/shm, so an attacher
+ * wakes as soon as the creator's shm_open() lands. System V ids have no
+ * notification, so those retries back off exponentially from 1 ms.
+ *
+ * Once attached, a reader waits on the segment's state word as a futex and
+ * the writer wakes it as soon as the contents are published.
+ *
+ * Only a missing object is worth waiting for: callers give up at once on
+ * any other error, so a denied attach costs one system call, not seconds.
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <limits.h>
+#include <sys/inotify.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "mls_wait.h"
+#include "mls_event.h"
+
+
+void deadline_init(struct deadline *d, int ms)
+{
+    clock_gettime(CLOCK_MONOTONIC, &d->end);
+    d->end.tv_sec += ms / 1000;
+    d->end.tv_nsec += (ms % 1000) * 1000000L;
+    if (d->end.tv_nsec >= 1000000000L) {
+        d->end.tv_sec++;
+        d->end.tv_nsec -= 1000000000L;
+    }
+    d->backoff_ms = BACKOFF_MIN_MS;
+}
+
+
+int deadline_left_ms(const struct deadline *d)
+{
+    struct timespec now;
+    long ms;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    ms = (d->end.tv_sec - now.tv_sec) * 1000 +
+         (d->end.tv_nsec - now.tv_nsec) / 1000000L;
+    return (ms > 0) ? (int)ms : 0;
+}
+
+
+/*
+ * Sleep before the next try, doubling the wait each time
+ *
+ * Returns 1 if it is worth trying again, 0 once the deadline has passed
+ */
+int wait_retry(struct deadline *d)
+{
+    EVENT_PHASE();
+    struct timespec ts;
+    int left = deadline_left_ms(d);
+    int ms = d->backoff_ms;
+
+    if (left == 0) return 0;
+    if (ms > left) ms = left;
+    printf("Retrying in %d ms.\n", ms);
+    ts.tv_sec = ms / 1000;
+    ts.tv_nsec = (ms % 1000) * 1000000L;
+    while (nanosleep(&ts, &ts) == -1 && errno == EINTR)
+        ;
+    if (d->backoff_ms < BACKOFF_MAX_MS) d->backoff_ms *= 2;
+    return 1;
+}
+
+
+/*
+ * Wait for the POSIX shm object name (as given to shm_open) to be created.
+ * The first call only installs the watch, so the caller retries once with
+ * the watch in place and cannot miss a creation in between.
+ *
+ * Returns 1 if it is worth trying again, 0 once the deadline has passed
+ */
+int wait_shm_created(const char *name, struct deadline *d)
+{
+    EVENT_PHASE();
+    static int ifd = -1;
+    char buf[sizeof(struct inotify_event) + NAME_MAX + 1]
+        __attribute__((aligned(__alignof__(struct inotify_event))));
+    const struct inotify_event *ev;
+    struct pollfd pfd;
+    ssize_t len;
+    char *p;
+    int left;
+
+    if (name[0] == '/') name++;
+
+    if (ifd < 0) {
+        ifd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (ifd < 0 || inotify_add_watch(ifd, SHM_DIR,
+                                         IN_CREATE | IN_MOVED_TO) < 0) {
+            perror("inotify failed, polling instead");
+            if (ifd >= 0) close(ifd);
+            ifd = -2;
+        }
+        return deadline_left_ms(d) > 0;
+    }
+    if (ifd == -2) {
+        return wait_retry(d);
+    }
+
+    while ((left = deadline_left_ms(d)) > 0) {
+        pfd.fd = ifd;
+        pfd.events = POLLIN;
+        if (poll(&pfd, 1, left) <= 0) continue;
+
+        len = read(ifd, buf, sizeof(buf));
+        for (p = buf; len > 0 && p < buf + len;
+             p += sizeof(struct inotify_event) + ev->len) {
+            ev = (const struct inotify_event *)p;
+            if (ev->len > 0 && strcmp(ev->name, name) == 0) {
+                printf("%s created.\n", name);
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+
+unsigned long long monotonic_ns(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000000ULL + now.tv_nsec;
+}
+
+
+/*
+ * Sleep while *word still holds val. The word lives in memory shared with
+ * other processes, so this is a shared (not private) futex; waiting only
+ * needs read access, so a read-only mapping will do.
+ *
+ * Returns 1 if it is worth looking at the word again, 0 once the deadline
+ * has passed
+ */
+int futex_wait_change(unsigned int *word, unsigned int val,
+                      struct deadline *d)
+{
+    EVENT_PHASE();
+    struct timespec ts;
+    int left = deadline_left_ms(d);
+
+    if (left == 0) return 0;
+    ts.tv_sec = left / 1000;
+    ts.tv_nsec = (left % 1000) * 1000000L;
+    if (syscall(SYS_futex, word, FUTEX_WAIT, val, &ts, NULL, 0) == -1 &&
+        errno != EAGAIN && errno != EINTR && errno != ETIMEDOUT) {
+        // no futex on this mapping; fall back to polling
+        return wait_retry(d);
+    }
+    return 1;
+}
+
+
+void futex_wake_all(unsigned int *word)
+{
+    syscall(SYS_futex, word, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+}
@@ -0,0 +1,32 @@
+/*
+ * A Unit test for Bell-LaPadula enforcement under SELinux-MLS
+ *
+ * \author Copyright (c) 2013, Mark Gondree
+ * \author Copyright (c) 2013, Aaron Flemming
+ * \date 2013-2013
+ * \copyright BSD 2-Clause License
+ *            See http://opensource.org/licenses/BSD-2-Clause
+ */
+#ifndef __TEST_MLS_WAIT_H__
+#define __TEST_MLS_WAIT_H__
+#include <time.h>
+
+#define SHM_DIR         "/dev/shm"
+#define BACKOFF_MIN_MS  1
+#define BACKOFF_MAX_MS  64
+
+struct deadline {
+    struct timespec end;        // CLOCK_MONOTONIC
+    int backoff_ms;             // next wait for wait_retry()
+};
+
+void deadline_init(struct deadline *d, int ms);
+int deadline_left_ms(const struct deadline *d);
+int wait_retry(struct deadline *d);
+int wait_shm_created(const char *name, struct deadline *d);
+unsigned long long monotonic_ns(void);
+int futex_wait_change(unsigned int *word, unsigned int val,
+                      struct deadline *d);
+void futex_wake_all(unsigned int *word);
+
+#endif